@@ -99,3 +99,111 @@ void sensirion_common_copy_bytes(const uint8_t* source, uint8_t* destination,
         destination[i] = source[i];
     }
 }
+
+void sensirion_common_reader_init(struct sensirion_common_reader* reader,
+                                  const uint8_t* data, uint16_t length) {
+    reader->data = data;
+    reader->length = length;
+    reader->offset = 0;
+    reader->error = false;
+}
+
+/* pointer to the next size bytes which are then skipped, NULL and error if
+ * there are not enough bytes left */
+static const uint8_t*
+sensirion_common_reader_take(struct sensirion_common_reader* reader,
+                             uint16_t size) {
+    const uint8_t* bytes;
+
+    if (reader->error || size > reader->length - reader->offset) {
+        reader->error = true;
+        return NULL;
+    }
+    bytes = reader->data + reader->offset;
+    reader->offset += size;
+    return bytes;
+}
+
+uint8_t
+sensirion_common_reader_get_uint8_t(struct sensirion_common_reader* reader) {
+    const uint8_t* bytes = sensirion_common_reader_take(reader, 1);
+
+    return bytes ? bytes[0] : 0;
+}
+
+uint16_t
+sensirion_common_reader_get_uint16_t(struct sensirion_common_reader* reader) {
+    const uint8_t* bytes = sensirion_common_reader_take(reader, 2);
+
+    return bytes ? sensirion_common_bytes_to_uint16_t(bytes) : 0;
+}
+
+int16_t
+sensirion_common_reader_get_int16_t(struct sensirion_common_reader* reader) {
+    return (int16_t)sensirion_common_reader_get_uint16_t(reader);
+}
+
+uint32_t
+sensirion_common_reader_get_uint32_t(struct sensirion_common_reader* reader) {
+    const uint8_t* bytes = sensirion_common_reader_take(reader, 4);
+
+    return bytes ? sensirion_common_bytes_to_uint32_t(bytes) : 0;
+}
+
+int32_t
+sensirion_common_reader_get_int32_t(struct sensirion_common_reader* reader) {
+    return (int32_t)sensirion_common_reader_get_uint32_t(reader);
+}
+
+float
+sensirion_common_reader_get_float(struct sensirion_common_reader* reader) {
+    const uint8_t* bytes = sensirion_common_reader_take(reader, 4);
+
+    return bytes ? sensirion_common_bytes_to_float(bytes) : 0;
+}
+
+void sensirion_common_reader_get_uint16_t_array(
+    struct sensirion_common_reader* reader, uint16_t* values, uint16_t count) {
+    const uint8_t* bytes = NULL;
+    uint16_t i;
+
+    if (count <= 0xFFFF / 2)
+        bytes = sensirion_common_reader_take(reader, (uint16_t)(count * 2));
+    else
+        reader->error = true;
+
+    if (!bytes) {
+        for (i = 0; i < count; ++i)
+            values[i] = 0;
+        return;
+    }
+    for (i = 0; i < count; ++i, bytes += 2)
+        values[i] = (uint16_t)((uint16_t)bytes[0] << 8 | bytes[1]);
+}
+
+void sensirion_common_reader_get_float_array(
+    struct sensirion_common_reader* reader, float* values, uint16_t count) {
+    const uint8_t* bytes = NULL;
+    uint16_t i;
+    union {
+        uint32_t u32_value;
+        float float32;
+    } tmp;
+
+    if (count <= 0xFFFF / 4)
+        bytes = sensirion_common_reader_take(reader, (uint16_t)(count * 4));
+    else
+        reader->error = true;
+
+    if (!bytes) {
+        for (i = 0; i < count; ++i)
+            values[i] = 0;
+        return;
+    }
+    /* one bounds check for the whole array, then only byte swapping */
+    for (i = 0; i < count; ++i, bytes += 4) {
+        tmp.u32_value = (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 |
+                        (uint32_t)bytes[2] << 8 | (uint32_t)bytes[3];
+        values[i] = tmp.float32;
+    }
+}
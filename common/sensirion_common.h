@@ -50,6 +50,21 @@ extern "C" {
 #define SENSIRION_NUM_WORDS(x) (sizeof(x) / SENSIRION_WORD_SIZE)
 #define SENSIRION_MAX_BUFFER_WORDS 32
 
+/**
+ * Read cursor over received big-endian data, e.g. the data of an SHDLC frame
+ * received with sensirion_shdlc_rx_inplace() or the bytes read with
+ * sensirion_i2c_read_words_as_bytes().
+ *
+ * Reads past the end return 0 and set the error flag, which stays set. So a
+ * whole response can be decoded first and checked once at the end.
+ */
+struct sensirion_common_reader {
+    const uint8_t* data;
+    uint16_t length;
+    uint16_t offset; /* offset of the next value in data */
+    bool error;      /* a read past the end of data was attempted */
+};
+
 /**
  * sensirion_common_bytes_to_int16_t() - Convert an array of bytes to an int16_t
  *
@@ -174,6 +189,93 @@ void sensirion_common_float_to_bytes(const float value, uint8_t* bytes);
 void sensirion_common_copy_bytes(const uint8_t* source, uint8_t* destination,
                                  uint16_t data_length);
 
+/**
+ * sensirion_common_reader_init() - Start reading values from received data
+ *
+ * @param reader Reader to initialize
+ * @param data   Received data
+ * @param length Number of bytes in data
+ */
+void sensirion_common_reader_init(struct sensirion_common_reader* reader,
+                                  const uint8_t* data, uint16_t length);
+
+/**
+ * sensirion_common_reader_get_uint8_t() - Read the next uint8_t
+ *
+ * @param reader Reader to take the value from
+ * @return       The value or 0 if there is no more data
+ */
+uint8_t
+sensirion_common_reader_get_uint8_t(struct sensirion_common_reader* reader);
+
+/**
+ * sensirion_common_reader_get_uint16_t() - Read the next uint16_t
+ *
+ * @param reader Reader to take the value from
+ * @return       The value or 0 if there is not enough data left
+ */
+uint16_t
+sensirion_common_reader_get_uint16_t(struct sensirion_common_reader* reader);
+
+/**
+ * sensirion_common_reader_get_int16_t() - Read the next int16_t
+ *
+ * @param reader Reader to take the value from
+ * @return       The value or 0 if there is not enough data left
+ */
+int16_t
+sensirion_common_reader_get_int16_t(struct sensirion_common_reader* reader);
+
+/**
+ * sensirion_common_reader_get_uint32_t() - Read the next uint32_t
+ *
+ * @param reader Reader to take the value from
+ * @return       The value or 0 if there is not enough data left
+ */
+uint32_t
+sensirion_common_reader_get_uint32_t(struct sensirion_common_reader* reader);
+
+/**
+ * sensirion_common_reader_get_int32_t() - Read the next int32_t
+ *
+ * @param reader Reader to take the value from
+ * @return       The value or 0 if there is not enough data left
+ */
+int32_t
+sensirion_common_reader_get_int32_t(struct sensirion_common_reader* reader);
+
+/**
+ * sensirion_common_reader_get_float() - Read the next float
+ *
+ * @param reader Reader to take the value from
+ * @return       The value or 0 if there is not enough data left
+ */
+float sensirion_common_reader_get_float(struct sensirion_common_reader* reader);
+
+/**
+ * sensirion_common_reader_get_uint16_t_array() - Read consecutive uint16_t
+ *
+ * If there is not enough data left, nothing is read and values are set to 0.
+ *
+ * @param reader Reader to take the values from
+ * @param values Memory where the values are stored
+ * @param count  Number of values to read
+ */
+void sensirion_common_reader_get_uint16_t_array(
+    struct sensirion_common_reader* reader, uint16_t* values, uint16_t count);
+
+/**
+ * sensirion_common_reader_get_float_array() - Read consecutive floats
+ *
+ * If there is not enough data left, nothing is read and values are set to 0.
+ *
+ * @param reader Reader to take the values from
+ * @param values Memory where the values are stored
+ * @param count  Number of values to read
+ */
+void sensirion_common_reader_get_float_array(
+    struct sensirion_common_reader* reader, float* values, uint16_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -85,4 +85,62 @@
 
 #endif /* __cplusplus */
 
+/**
+ * Select the engine used by sensirion_i2c_generate_crc() to calculate the CRC
+ * of the I2C data words. All engines produce the same checksums, they only
+ * trade memory for speed:
+ *
+ * SENSIRION_I2C_CRC_ENGINE_BITWISE       No table, eight shifts per byte.
+ * SENSIRION_I2C_CRC_ENGINE_NIBBLE_TABLE  16 byte table in flash, two lookups
+ *                                        per byte. For flash constrained
+ *                                        platforms.
+ * SENSIRION_I2C_CRC_ENGINE_BYTE_TABLE    256 byte table in flash, one lookup
+ *                                        per byte.
+ * SENSIRION_I2C_CRC_ENGINE_WORD_TABLE    256 byte table in flash plus a 64 KiB
+ *                                        table in RAM which is filled by
+ *                                        sensirion_i2c_crc_init(). One lookup
+ *                                        per data word. Only meant for hosts
+ *                                        like Linux gateways.
+ */
+#ifndef SENSIRION_I2C_CRC_ENGINE
+#define SENSIRION_I2C_CRC_ENGINE SENSIRION_I2C_CRC_ENGINE_BITWISE
+#endif
+
+/**
+ * Resolution of sensirion_i2c_hal_get_time_usec() in microseconds, e.g. 1000
+ * for a millisecond tick. It is added to the time at which a command result
+ * can be read, so the result is not read early if the clock ticks right after
+ * the command was sent. Set it to 1 for microsecond clocks like on Linux.
+ */
+#ifndef SENSIRION_I2C_HAL_TIME_RESOLUTION_USEC
+#define SENSIRION_I2C_HAL_TIME_RESOLUTION_USEC 1000
+#endif
+
+/**
+ * Max number of data bytes in an SHDLC frame, at most 255. The transmit
+ * buffer on the stack takes about twice this size, so setting it to the
+ * longest frame of the used devices saves stack. Longer frames are rejected
+ * with SENSIRION_SHDLC_ERR_FRAME_TOO_LONG.
+ */
+#ifndef SENSIRION_SHDLC_MAX_DATA_LENGTH
+#define SENSIRION_SHDLC_MAX_DATA_LENGTH 255
+#endif
+
+/**
+ * Number of (address, command) pairs per UART port for which the SHDLC driver
+ * keeps the expected response time and the timeout, see
+ * sensirion_shdlc_set_command_timing().
+ */
+#ifndef SENSIRION_SHDLC_MAX_COMMAND_TIMINGS
+#define SENSIRION_SHDLC_MAX_COMMAND_TIMINGS 16
+#endif
+
+/**
+ * Size of the receive buffer of each SHDLC port. A read takes up to this many
+ * bytes at once, bytes following a received frame are kept for the next one.
+ */
+#ifndef SENSIRION_SHDLC_RX_BUFFER_SIZE
+#define SENSIRION_SHDLC_RX_BUFFER_SIZE 64
+#endif
+
 #endif /* SENSIRION_CONFIG_H */
@@ -80,6 +80,67 @@ int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
     return i2c_master_write_packet_wait_no_stop(&i2c_master_instance, &packet);
 }
 
+int8_t sensirion_i2c_hal_write_read(uint8_t address, const uint8_t* tx_data,
+                                    uint8_t tx_count, uint8_t* rx_data,
+                                    uint8_t rx_count) {
+    int8_t ret;
+
+    ret = sensirion_i2c_hal_write(address, tx_data, tx_count);
+    if (ret)
+        return ret;
+
+    /* the write did not send a stop, the read starts with a repeated start */
+    return sensirion_i2c_hal_read(address, rx_data, rx_count);
+}
+
+int8_t sensirion_i2c_hal_transfer(struct sensirion_i2c_hal_transfer* transfers,
+                                  uint16_t count) {
+    return NOT_IMPLEMENTED_ERROR; /* executed one by one by sensirion_i2c */
+}
+
+/* single-bus setup, the bus handle is ignored */
+int16_t sensirion_i2c_hal_bus_init(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t bus_idx) {
+    bus->bus_idx = bus_idx;
+    bus->handle = 0;
+    bus->address = 0;
+    return NO_ERROR;
+}
+
+void sensirion_i2c_hal_bus_free(struct sensirion_i2c_hal_bus* bus) {
+}
+
+int8_t sensirion_i2c_hal_bus_read(struct sensirion_i2c_hal_bus* bus,
+                                  uint8_t address, uint8_t* data,
+                                  uint8_t count) {
+    return sensirion_i2c_hal_read(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_bus_write(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t address, const uint8_t* data,
+                                   uint8_t count) {
+    return sensirion_i2c_hal_write(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_bus_write_read(struct sensirion_i2c_hal_bus* bus,
+                                        uint8_t address, const uint8_t* tx_data,
+                                        uint8_t tx_count, uint8_t* rx_data,
+                                        uint8_t rx_count) {
+    return sensirion_i2c_hal_write_read(address, tx_data, tx_count, rx_data,
+                                        rx_count);
+}
+
+int8_t
+sensirion_i2c_hal_bus_transfer(struct sensirion_i2c_hal_bus* bus,
+                               struct sensirion_i2c_hal_transfer* transfers,
+                               uint16_t count) {
+    return sensirion_i2c_hal_transfer(transfers, count);
+}
+
+uint32_t sensirion_i2c_hal_get_time_usec(void) {
+    return 0; /* no time source, the full command delay is slept */
+}
+
 void sensirion_i2c_hal_sleep_usec(uint32_t useconds) {
     delay_us(useconds);
 }
@@ -37,12 +37,17 @@
 #include <stdlib.h>    /* exit */
 #include <string.h>    /* strlen */
 #include <sys/types.h> /* mode_t */
+#include <time.h>      /* clock_gettime */
 #include <unistd.h>    /* access, lseek, read, usleep */
 
 #include "sensirion_common.h"
 #include "sensirion_config.h"
 #include "sensirion_i2c_gpio.h"
 
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+#error "SENSIRION_I2C_GPIO_OPEN_DRAIN is not supported by this sample"
+#endif
+
 /*
  * We use the following names for the two I2C signal lines:
  * SCL for the clock line
@@ -215,18 +220,55 @@ uint8_t sensirion_i2c_gpio_SCL_read(void) {
     return gpio_get_value(scl_val_fd);
 }
 
+/**
+ * Wait until the SCL pin is high, i.e. until a device stops stretching the
+ * clock.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR to let the HAL
+ * poll SCL instead.
+ *
+ * @param timeout_usec maximal time to wait in microseconds
+ * @returns 0 if SCL is high, SENSIRION_I2C_GPIO_TIMEOUT_ERROR if it is still
+ *          low after the timeout or NOT_IMPLEMENTED_ERROR
+ */
+int16_t sensirion_i2c_gpio_SCL_wait_high(uint32_t timeout_usec) {
+    return NOT_IMPLEMENTED_ERROR; /* see linux_user_space_gpio_cdev */
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution approximately, but no less than, the given time.
  *
- * The precision needed depends on the desired i2c frequency, i.e. should be
- * exact to about half a clock cycle (defined in
- * `SENSIRION_I2C_CLOCK_PERIOD_USEC` in `sensirion_i2c_gpio.h`).
- *
- * Example with 400kHz requires a precision of 1 / (2 * 400kHz) == 1.25usec.
+ * Only used for the command delays, the precision needed is thus low.
  *
  * @param useconds the sleep time in microseconds
  */
 void sensirion_i2c_gpio_sleep_usec(uint32_t useconds) {
     usleep(useconds);
 }
+
+/**
+ * Sleep for a given number of nanoseconds. The function should delay the
+ * execution approximately, but no less than, the given time.
+ *
+ * Only used for delays of 100us and more, the HAL spins on
+ * sensirion_i2c_gpio_get_time_nsec() for shorter ones.
+ *
+ * @param nseconds the sleep time in nanoseconds
+ */
+void sensirion_i2c_gpio_sleep_nsec(uint32_t nseconds) {
+    usleep((nseconds + 999) / 1000);
+}
+
+/**
+ * Return a monotonic timestamp in nanoseconds. It may wrap around, only the
+ * difference of two timestamps is used.
+ *
+ * @returns the time in nanoseconds
+ */
+uint32_t sensirion_i2c_gpio_get_time_nsec(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return (uint32_t)now.tv_sec * 1000000000 + (uint32_t)now.tv_nsec;
+}
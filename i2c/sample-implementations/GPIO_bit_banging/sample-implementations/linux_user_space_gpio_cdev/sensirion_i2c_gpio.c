@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2026, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Enable usleep function */
+#define _DEFAULT_SOURCE
+
+#include <errno.h>       /* errno, EINTR */
+#include <fcntl.h>       /* open */
+#include <linux/gpio.h>  /* GPIO character device uAPI v2 */
+#include <stdio.h>       /* fprintf, perror, stderr */
+#include <stdlib.h>      /* exit */
+#include <poll.h>        /* poll */
+#include <string.h>      /* memset, strncpy */
+#include <sys/ioctl.h>   /* ioctl */
+#include <time.h>        /* clock_gettime */
+#include <unistd.h>      /* close, read, usleep */
+
+#include "sensirion_common.h"
+#include "sensirion_config.h"
+#include "sensirion_i2c_gpio.h"
+
+/*
+ * We use the following names for the two I2C signal lines:
+ * SCL for the clock line
+ * SDA for the data line
+ *
+ * Both lines must be equipped with pull-up resistors appropriate to the bus
+ * frequency.
+ *
+ * The lines are requested from the GPIO character device (Linux 5.10 or
+ * newer), so every pin operation is a single ioctl on the line file
+ * descriptor instead of writing and parsing strings in sysfs.
+ *
+ * With SENSIRION_I2C_GPIO_OPEN_DRAIN defined the lines are requested as
+ * open-drain outputs and are released by writing 1 instead of switching them
+ * to inputs.
+ *
+ * Long clock stretching is waited for with a rising edge event on SCL, if
+ * the GPIO chip supports edge detection.
+ */
+#ifndef GPIO_CHIP_PATH
+#define GPIO_CHIP_PATH "/dev/gpiochip0"
+#endif
+#ifndef GPIO_LINE_SCL
+#define GPIO_LINE_SCL 12
+#endif
+#ifndef GPIO_LINE_SDA
+#define GPIO_LINE_SDA 13
+#endif
+#define GPIO_CONSUMER "sensirion-i2c"
+
+static int scl_fd = -1;
+static int sda_fd = -1;
+/* line configs for the released (high) and the driven low state */
+static struct gpio_v2_line_config line_released;
+#ifndef SENSIRION_I2C_GPIO_OPEN_DRAIN
+static struct gpio_v2_line_config line_low;
+#endif
+/* released input with rising edge events to wait for a stretched clock */
+static struct gpio_v2_line_config line_wait_high;
+static bool edge_events_unsupported;
+
+static uint64_t gpio_time_nsec(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static void ioctl_or_exit(int fd, unsigned long request, void* arg,
+                          const char* what) {
+    if (ioctl(fd, request, arg) < 0) {
+        perror(what);
+        exit(-1);
+    }
+}
+
+static int gpio_request_line(int chip_fd, uint32_t offset) {
+    struct gpio_v2_line_request request;
+
+    memset(&request, 0, sizeof(request));
+    request.offsets[0] = offset;
+    request.num_lines = 1;
+    strncpy(request.consumer, GPIO_CONSUMER, sizeof(request.consumer) - 1);
+    request.config = line_released;
+    ioctl_or_exit(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request,
+                  "Error requesting GPIO line");
+    return request.fd;
+}
+
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+static void gpio_set_value(int fd, uint8_t value) {
+    struct gpio_v2_line_values values;
+
+    values.bits = value;
+    values.mask = 1;
+    ioctl_or_exit(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values,
+                  "Error writing GPIO value");
+}
+#endif
+
+static void gpio_set_config(int fd, struct gpio_v2_line_config* config) {
+    ioctl_or_exit(fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, config,
+                  "Error configuring GPIO line");
+}
+
+static uint8_t gpio_get_value(int fd) {
+    struct gpio_v2_line_values values;
+
+    values.bits = 0;
+    values.mask = 1;
+    ioctl_or_exit(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values,
+                  "Error reading GPIO value");
+    return (uint8_t)(values.bits & 1);
+}
+
+/**
+ * Initialize all hard- and software components that are needed to set the
+ * SDA and SCL pins.
+ */
+void sensirion_i2c_gpio_init_pins(void) {
+    int chip_fd;
+
+    memset(&line_released, 0, sizeof(line_released));
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+    /* released open-drain outputs */
+    line_released.flags =
+        GPIO_V2_LINE_FLAG_OUTPUT | GPIO_V2_LINE_FLAG_OPEN_DRAIN;
+    line_released.num_attrs = 1;
+    line_released.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+    line_released.attrs[0].attr.values = 1;
+    line_released.attrs[0].mask = 1;
+#else
+    line_released.flags = GPIO_V2_LINE_FLAG_INPUT;
+    /* lines without output value attribute are driven inactive (low) */
+    memset(&line_low, 0, sizeof(line_low));
+    line_low.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+#endif
+    memset(&line_wait_high, 0, sizeof(line_wait_high));
+    line_wait_high.flags =
+        GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING;
+
+    chip_fd = open(GPIO_CHIP_PATH, O_RDWR);
+    if (chip_fd < 0) {
+        perror(NULL);
+        fprintf(stderr, "Error opening %s\n", GPIO_CHIP_PATH);
+        exit(-1);
+    }
+    scl_fd = gpio_request_line(chip_fd, GPIO_LINE_SCL);
+    sda_fd = gpio_request_line(chip_fd, GPIO_LINE_SDA);
+    /* the requested lines stay valid without the chip */
+    close(chip_fd);
+}
+
+/**
+ * Release all resources initialized by sensirion_i2c_gpio_init_pins()
+ */
+void sensirion_i2c_gpio_release_pins(void) {
+    close(scl_fd);
+    close(sda_fd);
+    scl_fd = -1;
+    sda_fd = -1;
+}
+
+/**
+ * Configure the SDA pin as an input. With an external pull-up resistor the line
+ * should be left floating, without external pull-up resistor, the input must be
+ * configured to use the internal pull-up resistor.
+ */
+void sensirion_i2c_gpio_SDA_in(void) {
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+    gpio_set_value(sda_fd, 1);
+#else
+    gpio_set_config(sda_fd, &line_released);
+#endif
+}
+
+/**
+ * Configure the SDA pin as an output and drive it low or set to logical false.
+ */
+void sensirion_i2c_gpio_SDA_out(void) {
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+    gpio_set_value(sda_fd, 0);
+#else
+    gpio_set_config(sda_fd, &line_low);
+#endif
+}
+
+/**
+ * Read the value of the SDA pin.
+ * @returns 0 if the pin is low and 1 otherwise.
+ */
+uint8_t sensirion_i2c_gpio_SDA_read(void) {
+    return gpio_get_value(sda_fd);
+}
+
+/**
+ * Configure the SCL pin as an input. With an external pull-up resistor the line
+ * should be left floating, without external pull-up resistor, the input must be
+ * configured to use the internal pull-up resistor.
+ */
+void sensirion_i2c_gpio_SCL_in(void) {
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+    gpio_set_value(scl_fd, 1);
+#else
+    gpio_set_config(scl_fd, &line_released);
+#endif
+}
+
+/**
+ * Configure the SCL pin as an output and drive it low or set to logical false.
+ */
+void sensirion_i2c_gpio_SCL_out(void) {
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+    gpio_set_value(scl_fd, 0);
+#else
+    gpio_set_config(scl_fd, &line_low);
+#endif
+}
+
+/**
+ * Read the value of the SCL pin.
+ * @returns 0 if the pin is low and 1 otherwise.
+ */
+uint8_t sensirion_i2c_gpio_SCL_read(void) {
+    return gpio_get_value(scl_fd);
+}
+
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+/**
+ * Drive the SDA pin low (0) or release it (1) so that the pull-up resistor
+ * pulls it high.
+ */
+void sensirion_i2c_gpio_SDA_write(uint8_t value) {
+    gpio_set_value(sda_fd, value);
+}
+
+/**
+ * Drive the SCL pin low (0) or release it (1) so that the pull-up resistor
+ * pulls it high.
+ */
+void sensirion_i2c_gpio_SCL_write(uint8_t value) {
+    gpio_set_value(scl_fd, value);
+}
+#endif /* SENSIRION_I2C_GPIO_OPEN_DRAIN */
+
+/**
+ * Wait until the SCL pin is high, i.e. until a device stops stretching the
+ * clock.
+ *
+ * SCL is switched to an input with rising edge detection while waiting, the
+ * line stays released either way. The event only wakes us up, the level is
+ * read again so that old events do not count.
+ *
+ * @param timeout_usec maximal time to wait in microseconds
+ * @returns 0 if SCL is high, SENSIRION_I2C_GPIO_TIMEOUT_ERROR if it is still
+ *          low after the timeout or NOT_IMPLEMENTED_ERROR if the GPIO chip
+ *          has no edge detection
+ */
+int16_t sensirion_i2c_gpio_SCL_wait_high(uint32_t timeout_usec) {
+    struct gpio_v2_line_event events[16];
+    struct pollfd pfd;
+    uint64_t deadline;
+    uint64_t now;
+    int16_t ret = SENSIRION_I2C_GPIO_TIMEOUT_ERROR;
+    int ready;
+
+    if (edge_events_unsupported)
+        return NOT_IMPLEMENTED_ERROR;
+    if (ioctl(scl_fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, &line_wait_high) < 0) {
+        edge_events_unsupported = true;
+        return NOT_IMPLEMENTED_ERROR;
+    }
+
+    deadline = gpio_time_nsec() + (uint64_t)timeout_usec * 1000;
+    pfd.fd = scl_fd;
+    pfd.events = POLLIN;
+    for (;;) {
+        /* read after enabling the edge detection to not miss the edge */
+        if (gpio_get_value(scl_fd)) {
+            ret = NO_ERROR;
+            break;
+        }
+        now = gpio_time_nsec();
+        if (now >= deadline)
+            break;
+        ready = poll(&pfd, 1, (int)((deadline - now + 999999) / 1000000));
+        if (ready < 0 && errno != EINTR) {
+            perror("Error waiting for GPIO edge");
+            exit(-1);
+        }
+        /* discard the events */
+        if (ready > 0 && read(scl_fd, events, sizeof(events)) < 0 &&
+            errno != EINTR) {
+            perror("Error reading GPIO edge");
+            exit(-1);
+        }
+    }
+    gpio_set_config(scl_fd, &line_released);
+    return ret;
+}
+
+/**
+ * Sleep for a given number of microseconds. The function should delay the
+ * execution approximately, but no less than, the given time.
+ *
+ * Only used for the command delays, the precision needed is thus low.
+ *
+ * @param useconds the sleep time in microseconds
+ */
+void sensirion_i2c_gpio_sleep_usec(uint32_t useconds) {
+    usleep(useconds);
+}
+
+/**
+ * Sleep for a given number of nanoseconds. The function should delay the
+ * execution approximately, but no less than, the given time.
+ *
+ * Only used for delays of 100us and more, the HAL spins on
+ * sensirion_i2c_gpio_get_time_nsec() for shorter ones.
+ *
+ * @param nseconds the sleep time in nanoseconds
+ */
+void sensirion_i2c_gpio_sleep_nsec(uint32_t nseconds) {
+    usleep((nseconds + 999) / 1000);
+}
+
+/**
+ * Return a monotonic timestamp in nanoseconds. It may wrap around, only the
+ * difference of two timestamps is used.
+ *
+ * @returns the time in nanoseconds
+ */
+uint32_t sensirion_i2c_gpio_get_time_nsec(void) {
+    return (uint32_t)gpio_time_nsec();
+}
@@ -35,6 +35,10 @@
 #include "sensirion_config.h"
 #include "sensirion_i2c_gpio.h"
 
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+#error "SENSIRION_I2C_GPIO_OPEN_DRAIN is not supported by this sample"
+#endif
+
 /*
  * We use the following names for the two I2C signal lines:
  * SCL for the clock line
@@ -115,18 +119,49 @@ uint8_t sensirion_i2c_gpio_SCL_read(void) {
     return scl.read();
 }
 
+/**
+ * Wait until the SCL pin is high, i.e. until a device stops stretching the
+ * clock.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR to let the HAL
+ * poll SCL instead.
+ *
+ * @param timeout_usec maximal time to wait in microseconds
+ * @returns 0 if SCL is high, SENSIRION_I2C_GPIO_TIMEOUT_ERROR if it is still
+ *          low after the timeout or NOT_IMPLEMENTED_ERROR
+ */
+int16_t sensirion_i2c_gpio_SCL_wait_high(uint32_t timeout_usec) {
+    return NOT_IMPLEMENTED_ERROR; /* polled by the HAL */
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution approximately, but no less than, the given time.
  *
- * The precision needed depends on the desired i2c frequency, i.e. should be
- * exact to about half a clock cycle (defined in
- * `SENSIRION_I2C_CLOCK_PERIOD_USEC` in `sensirion_i2c_gpio.h`).
- *
- * Example with 400kHz requires a precision of 1 / (2 * 400kHz) == 1.25usec.
+ * Only used for the command delays, the precision needed is thus low.
  *
  * @param useconds the sleep time in microseconds
  */
 void sensirion_i2c_gpio_sleep_usec(uint32_t useconds) {
     wait_us(useconds);
 }
+
+/**
+ * Sleep for a given number of nanoseconds. The function should delay the
+ * execution approximately, but no less than, the given time.
+ *
+ * @param nseconds the sleep time in nanoseconds
+ */
+void sensirion_i2c_gpio_sleep_nsec(uint32_t nseconds) {
+    wait_ns(nseconds);
+}
+
+/**
+ * Return a monotonic timestamp in nanoseconds. It may wrap around, only the
+ * difference of two timestamps is used.
+ *
+ * @returns the time in nanoseconds or 0 if there is no time source
+ */
+uint32_t sensirion_i2c_gpio_get_time_nsec(void) {
+    return 0; /* no time source */
+}
@@ -36,17 +36,92 @@
 #include "sensirion_config.h"
 
 /**
- * The clock period of the i2c bus in microseconds. Increase this, if your GPIO
- * ports cannot support a 200 kHz output rate. (2 * 1 / 10usec == 200Khz)
+ * The initial clock period of the i2c bus in microseconds. Increase this, if
+ * your GPIO ports cannot support a 100 kHz output rate. (1 / 10usec == 100kHz)
+ * The period can be changed at runtime with
+ * sensirion_i2c_gpio_set_clock_period_nsec().
  *
  * This is only relevant for the sw-i2c HAL (bit-banging on GPIO pins). The
- * pulse length is half the clock period, the number should thus be even.
+ * pulse length is half the clock period.
  */
 #define SENSIRION_I2C_CLOCK_PERIOD_USEC 10
 
+/**
+ * Number of I2C addresses which can get their own clock period with
+ * sensirion_i2c_gpio_set_address_clock_period_nsec().
+ */
+#ifndef SENSIRION_I2C_GPIO_MAX_ADDRESS_CLOCKS
+#define SENSIRION_I2C_GPIO_MAX_ADDRESS_CLOCKS 4
+#endif
+
+#define SENSIRION_I2C_GPIO_CLOCK_TABLE_FULL_ERROR 32
+#define SENSIRION_I2C_GPIO_TIMEOUT_ERROR 33
+#define SENSIRION_I2C_GPIO_CLOCK_PERIOD_ERROR 34
+
 #ifdef __cplusplus
 extern "C" {
 #endif
+/**
+ * Set the clock period of the bus, used for all addresses without their own
+ * clock period. Fast-mode (400kHz) needs a period of at least 2600ns, as the
+ * clock must be low for at least 1.3usec, and pins fast enough for it.
+ *
+ * Implemented by the sw-i2c HAL (sensirion_i2c_hal.c in this folder).
+ *
+ * @param clock_period_nsec the clock period in nanoseconds
+ * @returns 0 on success, SENSIRION_I2C_GPIO_CLOCK_PERIOD_ERROR if the period
+ *          is 0
+ */
+int16_t sensirion_i2c_gpio_set_clock_period_nsec(uint32_t clock_period_nsec);
+
+/**
+ * Set the clock period used for transfers with the given address, e.g. to run
+ * a fast device at 400kHz on a bus which is slower for the other devices.
+ *
+ * Implemented by the sw-i2c HAL (sensirion_i2c_hal.c in this folder).
+ *
+ * @param address           7-bit I2C address
+ * @param clock_period_nsec the clock period in nanoseconds
+ * @returns 0 on success, SENSIRION_I2C_GPIO_CLOCK_PERIOD_ERROR if the period
+ *          is 0, SENSIRION_I2C_GPIO_CLOCK_TABLE_FULL_ERROR if
+ *          SENSIRION_I2C_GPIO_MAX_ADDRESS_CLOCKS addresses have their own
+ *          clock period already
+ */
+int16_t sensirion_i2c_gpio_set_address_clock_period_nsec(
+    uint8_t address, uint32_t clock_period_nsec);
+
+/**
+ * Use the clock period of the bus again for transfers with the given address.
+ *
+ * Implemented by the sw-i2c HAL (sensirion_i2c_hal.c in this folder).
+ *
+ * @param address 7-bit I2C address
+ */
+void sensirion_i2c_gpio_reset_address_clock_period(uint8_t address);
+
+/**
+ * Return the clock period used for transfers with the given address.
+ *
+ * Implemented by the sw-i2c HAL (sensirion_i2c_hal.c in this folder).
+ *
+ * @param address 7-bit I2C address
+ * @returns the clock period in nanoseconds
+ */
+uint32_t sensirion_i2c_gpio_get_clock_period_nsec(uint8_t address);
+
+/**
+ * Return the SCL frequency really achieved for transfers with the given
+ * address, i.e. including the time the pin operations take on top of the
+ * clock period. The pin operations are timed in sensirion_i2c_hal_init().
+ *
+ * Implemented by the sw-i2c HAL (sensirion_i2c_hal.c in this folder).
+ *
+ * @param address 7-bit I2C address
+ * @returns the SCL frequency in Hz or 0 if the pin driver has no clock, see
+ *          sensirion_i2c_gpio_get_time_nsec()
+ */
+uint32_t sensirion_i2c_gpio_get_scl_frequency_hz(uint8_t address);
+
 /**
  * Initialize all hard- and software components that are needed to set the
  * SDA and SCL pins.
@@ -94,20 +169,80 @@ void sensirion_i2c_gpio_SCL_out(void);
  */
 uint8_t sensirion_i2c_gpio_SCL_read(void);
 
+/**
+ * Wait until the SCL pin is high, i.e. until a device stops stretching the
+ * clock, e.g. blocking on an edge event instead of polling the pin. The HAL
+ * polls SCL for a few clock periods first, so this is only used for long
+ * clock stretching.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR to let the HAL
+ * poll SCL instead.
+ *
+ * @param timeout_usec maximal time to wait in microseconds
+ * @returns 0 if SCL is high, SENSIRION_I2C_GPIO_TIMEOUT_ERROR if it is still
+ *          low after the timeout or NOT_IMPLEMENTED_ERROR
+ */
+int16_t sensirion_i2c_gpio_SCL_wait_high(uint32_t timeout_usec);
+
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+/**
+ * Open-drain pin interface, used instead of switching the pin directions if
+ * SENSIRION_I2C_GPIO_OPEN_DRAIN is defined (e.g. in sensirion_config.h). The
+ * pins must then be configured as open-drain outputs by
+ * sensirion_i2c_gpio_init_pins(), so every edge is a single write.
+ */
+
+/**
+ * Drive the SDA pin low (0) or release it (1) so that the pull-up resistor
+ * pulls it high.
+ */
+void sensirion_i2c_gpio_SDA_write(uint8_t value);
+
+/**
+ * Drive the SCL pin low (0) or release it (1) so that the pull-up resistor
+ * pulls it high.
+ */
+void sensirion_i2c_gpio_SCL_write(uint8_t value);
+#endif /* SENSIRION_I2C_GPIO_OPEN_DRAIN */
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution approximately, but no less than, the given time.
  *
- * The precision needed depends on the desired i2c frequency, i.e. should be
- * exact to about half a clock cycle (defined in
- * `SENSIRION_I2C_CLOCK_PERIOD_USEC` in `sensirion_i2c_gpio.h`).
- *
- * Example with 400kHz requires a precision of 1 / (2 * 400kHz) == 1.25usec.
+ * Only used for the command delays, the precision needed is thus low.
  *
  * @param useconds the sleep time in microseconds
  */
 void sensirion_i2c_gpio_sleep_usec(uint32_t useconds);
 
+/**
+ * Sleep for a given number of nanoseconds. The function should delay the
+ * execution approximately, but no less than, the given time.
+ *
+ * This is the delay between the clock edges, i.e. half the clock period. The
+ * precision needed thus depends on the desired i2c frequency.
+ *
+ * Example with 400kHz requires a precision of 1 / (2 * 400kHz) == 1250nsec.
+ *
+ * If sensirion_i2c_gpio_get_time_nsec() is implemented, the HAL spins on it
+ * for delays shorter than 100usec and only calls this for longer ones.
+ *
+ * @param nseconds the sleep time in nanoseconds
+ */
+void sensirion_i2c_gpio_sleep_nsec(uint32_t nseconds);
+
+/**
+ * Return a monotonic timestamp in nanoseconds. It may wrap around, only the
+ * difference of two timestamps is used.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. With a clock the HAL spins on it for short
+ * delays and measures the SCL frequency really achieved, see
+ * sensirion_i2c_gpio_get_scl_frequency_hz().
+ *
+ * @returns the time in nanoseconds or 0 if there is no time source
+ */
+uint32_t sensirion_i2c_gpio_get_time_nsec(void);
+
 #ifdef __cplusplus
 }
 #endif
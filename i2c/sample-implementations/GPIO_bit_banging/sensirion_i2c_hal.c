@@ -35,15 +35,67 @@
 #include "sensirion_i2c.h"
 #include "sensirion_i2c_gpio.h"
 
-#define DELAY_USEC (SENSIRION_I2C_CLOCK_PERIOD_USEC / 2)
+/* maximal clock stretching of 150ms (SCD30) */
+#define CLOCK_STRETCHING_TIMEOUT_NSEC 150000000
+/* shortest interval to poll a stretched clock */
+#define CLOCK_STRETCHING_MIN_POLL_NSEC 1000
+/* polls before waiting with sensirion_i2c_gpio_SCL_wait_high() */
+#define CLOCK_STRETCHING_SPIN_POLLS 8
+/* delays shorter than this are spun on the clock of the pin driver, if it
+ * has one, since sleeping takes 50us or more on an operating system */
+#define SPIN_LIMIT_NSEC 100000
+/* clock periods timed by sensirion_i2c_gpio_calibrate() */
+#define CALIBRATION_CLOCKS 64
+
+/**
+ * Release the lines to let the pull-up resistors pull them high or drive them
+ * low. Open-drain pins take a single write, otherwise the pin direction is
+ * switched.
+ */
+#ifdef SENSIRION_I2C_GPIO_OPEN_DRAIN
+#define SDA_RELEASE() sensirion_i2c_gpio_SDA_write(1)
+#define SDA_LOW() sensirion_i2c_gpio_SDA_write(0)
+#define SCL_RELEASE() sensirion_i2c_gpio_SCL_write(1)
+#define SCL_LOW() sensirion_i2c_gpio_SCL_write(0)
+#else
+#define SDA_RELEASE() sensirion_i2c_gpio_SDA_in()
+#define SDA_LOW() sensirion_i2c_gpio_SDA_out()
+#define SCL_RELEASE() sensirion_i2c_gpio_SCL_in()
+#define SCL_LOW() sensirion_i2c_gpio_SCL_out()
+#endif
+
+struct sensirion_i2c_gpio_address_clock {
+    uint8_t address;
+    uint32_t clock_period_nsec; /* 0 if the entry is unused */
+};
+
+static uint32_t bus_clock_period_nsec = SENSIRION_I2C_CLOCK_PERIOD_USEC * 1000;
+static struct sensirion_i2c_gpio_address_clock
+    address_clocks[SENSIRION_I2C_GPIO_MAX_ADDRESS_CLOCKS];
+
+/* clock period of the current transfer */
+static uint32_t clock_period_nsec = SENSIRION_I2C_CLOCK_PERIOD_USEC * 1000;
+/* delay between the clock edges, half the clock period */
+static uint32_t delay_nsec = SENSIRION_I2C_CLOCK_PERIOD_USEC * 1000 / 2;
+/* the pin driver implements sensirion_i2c_gpio_get_time_nsec() */
+static bool has_clock;
+/* time the pin operations add to a clock period */
+static uint32_t clock_overhead_nsec;
 
 /**
  * Declaration of static helpers.
  */
+static void sensirion_i2c_gpio_select_clock(uint8_t address);
+static void sensirion_i2c_gpio_delay_nsec(uint32_t nseconds);
+static void sensirion_i2c_gpio_calibrate(void);
 static int8_t sensirion_i2c_gpio_write_byte(uint8_t data);
 static uint8_t sensirion_i2c_gpio_read_byte(uint8_t ack);
 static int8_t sensirion_i2c_gpio_start(void);
 static void sensirion_i2c_gpio_stop(void);
+static int8_t sensirion_i2c_gpio_transmit(uint8_t address, const uint8_t* data,
+                                          uint8_t count);
+static int8_t sensirion_i2c_gpio_receive(uint8_t address, uint8_t* data,
+                                         uint8_t count);
 
 /**
  * Select the current i2c bus by index.
@@ -59,22 +111,84 @@ int16_t sensirion_i2c_hal_select_bus(uint8_t bus_idx) {
     return NO_ERROR; /* not relevant for software I2C */
 }
 
+int16_t sensirion_i2c_gpio_set_clock_period_nsec(uint32_t clock_period_nsec) {
+    if (!clock_period_nsec)
+        return SENSIRION_I2C_GPIO_CLOCK_PERIOD_ERROR;
+    bus_clock_period_nsec = clock_period_nsec;
+    return NO_ERROR;
+}
+
+int16_t sensirion_i2c_gpio_set_address_clock_period_nsec(
+    uint8_t address, uint32_t clock_period_nsec) {
+    struct sensirion_i2c_gpio_address_clock* entry = NULL;
+    uint16_t i;
+
+    if (!clock_period_nsec)
+        return SENSIRION_I2C_GPIO_CLOCK_PERIOD_ERROR;
+    for (i = 0; i < SENSIRION_I2C_GPIO_MAX_ADDRESS_CLOCKS; ++i) {
+        if (address_clocks[i].clock_period_nsec &&
+            address_clocks[i].address == address) {
+            entry = &address_clocks[i];
+            break;
+        }
+        if (!entry && !address_clocks[i].clock_period_nsec)
+            entry = &address_clocks[i];
+    }
+    if (!entry)
+        return SENSIRION_I2C_GPIO_CLOCK_TABLE_FULL_ERROR;
+
+    entry->address = address;
+    entry->clock_period_nsec = clock_period_nsec;
+    return NO_ERROR;
+}
+
+void sensirion_i2c_gpio_reset_address_clock_period(uint8_t address) {
+    uint16_t i;
+
+    for (i = 0; i < SENSIRION_I2C_GPIO_MAX_ADDRESS_CLOCKS; ++i) {
+        if (address_clocks[i].address == address)
+            address_clocks[i].clock_period_nsec = 0;
+    }
+}
+
+uint32_t sensirion_i2c_gpio_get_clock_period_nsec(uint8_t address) {
+    uint16_t i;
+
+    for (i = 0; i < SENSIRION_I2C_GPIO_MAX_ADDRESS_CLOCKS; ++i) {
+        if (address_clocks[i].clock_period_nsec &&
+            address_clocks[i].address == address)
+            return address_clocks[i].clock_period_nsec;
+    }
+    return bus_clock_period_nsec;
+}
+
+uint32_t sensirion_i2c_gpio_get_scl_frequency_hz(uint8_t address) {
+    uint32_t period_nsec;
+
+    if (!has_clock)
+        return 0;
+    period_nsec =
+        sensirion_i2c_gpio_get_clock_period_nsec(address) + clock_overhead_nsec;
+    return period_nsec ? 1000000000 / period_nsec : 0;
+}
+
 /**
  * Initialize all hard- and software components that are needed for the I2C
  * communication.
  */
 void sensirion_i2c_hal_init(void) {
     sensirion_i2c_gpio_init_pins();
-    sensirion_i2c_gpio_SCL_in();
-    sensirion_i2c_gpio_SDA_in();
+    SCL_RELEASE();
+    SDA_RELEASE();
+    sensirion_i2c_gpio_calibrate();
 }
 
 /**
  * Release all resources initialized by sensirion_i2c_hal_init().
  */
 void sensirion_i2c_hal_free(void) {
-    sensirion_i2c_gpio_SCL_in();
-    sensirion_i2c_gpio_SDA_in();
+    SCL_RELEASE();
+    SDA_RELEASE();
     sensirion_i2c_gpio_release_pins();
 }
 
@@ -90,25 +204,10 @@ void sensirion_i2c_hal_free(void) {
  */
 int8_t sensirion_i2c_hal_read(uint8_t address, uint8_t* data, uint8_t count) {
     int8_t ret;
-    uint8_t send_ack;
-    uint8_t i;
-
-    ret = sensirion_i2c_gpio_start();
-    if (ret != NO_ERROR)
-        return ret;
-
-    ret = sensirion_i2c_gpio_write_byte((address << 1) | 1);
-    if (ret != NO_ERROR) {
-        sensirion_i2c_gpio_stop();
-        return ret;
-    }
-    for (i = 0; i < count; i++) {
-        send_ack = i < (count - 1); /* last byte must be NACK'ed */
-        data[i] = sensirion_i2c_gpio_read_byte(send_ack);
-    }
 
+    ret = sensirion_i2c_gpio_receive(address, data, count);
     sensirion_i2c_gpio_stop();
-    return NO_ERROR;
+    return ret;
 }
 
 /**
@@ -125,28 +224,107 @@ int8_t sensirion_i2c_hal_read(uint8_t address, uint8_t* data, uint8_t count) {
 int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
                                uint8_t count) {
     int8_t ret;
-    uint8_t i;
 
-    ret = sensirion_i2c_gpio_start();
-    if (ret != NO_ERROR)
-        return ret;
+    ret = sensirion_i2c_gpio_transmit(address, data, count);
+    sensirion_i2c_gpio_stop();
+    return ret;
+}
 
-    ret = sensirion_i2c_gpio_write_byte(address << 1);
-    if (ret != NO_ERROR) {
-        sensirion_i2c_gpio_stop();
-        return ret;
-    }
-    for (i = 0; i < count; i++) {
-        ret = sensirion_i2c_gpio_write_byte(data[i]);
-        if (ret != NO_ERROR) {
-            sensirion_i2c_gpio_stop();
-            break;
-        }
-    }
+/**
+ * Execute a write transaction followed by a read transaction on the I2C bus
+ * without releasing the bus in between (repeated start), e.g. to send a
+ * command and read its response. If the device does not acknowledge any of
+ * the bytes, an error shall be returned.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR to let the
+ * caller use sensirion_i2c_hal_write() followed by sensirion_i2c_hal_read(),
+ * e.g. on platforms without support for repeated starts.
+ *
+ * @param address  7-bit I2C address to write to and read from
+ * @param tx_data  pointer to the buffer containing the data to write
+ * @param tx_count number of bytes to send over I2C
+ * @param rx_data  pointer to the buffer where the read data is to be stored
+ * @param rx_count number of bytes to read from I2C and store in the buffer
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_write_read(uint8_t address, const uint8_t* tx_data,
+                                    uint8_t tx_count, uint8_t* rx_data,
+                                    uint8_t rx_count) {
+    int8_t ret;
+
+    ret = sensirion_i2c_gpio_transmit(address, tx_data, tx_count);
+    if (ret == NO_ERROR)
+        ret = sensirion_i2c_gpio_receive(address, rx_data, rx_count);
     sensirion_i2c_gpio_stop();
     return ret;
 }
 
+/**
+ * Execute a list of transfers, possibly to different addresses, with as
+ * little overhead between them as the platform allows. The error member of
+ * every transfer must be set to 0 on success and to an error code otherwise.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR without touching
+ * the transfers to let the caller execute them one by one.
+ *
+ * @param transfers list of transfers to execute
+ * @param count     number of transfers in the list
+ * @returns 0 if all transfers succeeded, error code otherwise
+ */
+int8_t sensirion_i2c_hal_transfer(struct sensirion_i2c_hal_transfer* transfers,
+                                  uint16_t count) {
+    return NOT_IMPLEMENTED_ERROR; /* executed one by one by sensirion_i2c */
+}
+
+/**
+ * Single-bus implementation of the bus functions: the bus handle is ignored
+ * and all transfers are executed on the default bus.
+ */
+int16_t sensirion_i2c_hal_bus_init(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t bus_idx) {
+    bus->bus_idx = bus_idx;
+    bus->handle = 0;
+    bus->address = 0;
+    return NO_ERROR;
+}
+
+void sensirion_i2c_hal_bus_free(struct sensirion_i2c_hal_bus* bus) {
+}
+
+int8_t sensirion_i2c_hal_bus_read(struct sensirion_i2c_hal_bus* bus,
+                                  uint8_t address, uint8_t* data,
+                                  uint8_t count) {
+    return sensirion_i2c_hal_read(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_bus_write(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t address, const uint8_t* data,
+                                   uint8_t count) {
+    return sensirion_i2c_hal_write(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_bus_write_read(struct sensirion_i2c_hal_bus* bus,
+                                        uint8_t address, const uint8_t* tx_data,
+                                        uint8_t tx_count, uint8_t* rx_data,
+                                        uint8_t rx_count) {
+    return sensirion_i2c_hal_write_read(address, tx_data, tx_count, rx_data,
+                                        rx_count);
+}
+
+int8_t
+sensirion_i2c_hal_bus_transfer(struct sensirion_i2c_hal_bus* bus,
+                               struct sensirion_i2c_hal_transfer* transfers,
+                               uint16_t count) {
+    return sensirion_i2c_hal_transfer(transfers, count);
+}
+
+/**
+ * Return a monotonic timestamp in microseconds.
+ */
+uint32_t sensirion_i2c_hal_get_time_usec(void) {
+    return 0; /* no time source, the full command delay is slept */
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution for at least the given time, but may also sleep longer.
@@ -156,21 +334,85 @@ int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
  * @param useconds the sleep time in microseconds
  */
 void sensirion_i2c_hal_sleep_usec(uint32_t useconds) {
-    sensirion_i2c_gpio_sleep_usec(useconds);
+    if (has_clock && useconds < SPIN_LIMIT_NSEC / 1000)
+        sensirion_i2c_gpio_delay_nsec(useconds * 1000);
+    else
+        sensirion_i2c_gpio_sleep_usec(useconds);
 }
 
 /**
  * The following functions are static helpers.
  */
 
+static void sensirion_i2c_gpio_select_clock(uint8_t address) {
+    clock_period_nsec = sensirion_i2c_gpio_get_clock_period_nsec(address);
+    delay_nsec = clock_period_nsec / 2;
+}
+
+static void sensirion_i2c_gpio_delay_nsec(uint32_t nseconds) {
+    uint32_t start;
+
+    if (!has_clock || nseconds >= SPIN_LIMIT_NSEC) {
+        sensirion_i2c_gpio_sleep_nsec(nseconds);
+        return;
+    }
+    start = sensirion_i2c_gpio_get_time_nsec();
+    while (sensirion_i2c_gpio_get_time_nsec() - start < nseconds) {
+        /* spin */
+    }
+}
+
+/* time the pin operations and delays of a clock period as issued by
+ * sensirion_i2c_gpio_write_byte(). SDA stays released, so there is no start
+ * or stop condition and the devices ignore the clock pulses. */
+static void sensirion_i2c_gpio_calibrate(void) {
+    uint32_t start;
+    uint16_t i;
+
+    start = sensirion_i2c_gpio_get_time_nsec();
+    /* a clock doesn't read 0 twice in a row */
+    has_clock = start || sensirion_i2c_gpio_get_time_nsec();
+    if (!has_clock)
+        return;
+
+    for (i = 0; i < CALIBRATION_CLOCKS; ++i) {
+        SCL_LOW();
+        SDA_RELEASE();
+        sensirion_i2c_gpio_delay_nsec(0);
+        SCL_RELEASE();
+        sensirion_i2c_gpio_delay_nsec(0);
+        (void)sensirion_i2c_gpio_SCL_read();
+    }
+    clock_overhead_nsec =
+        (sensirion_i2c_gpio_get_time_nsec() - start) / CALIBRATION_CLOCKS;
+}
+
 static int8_t sensirion_wait_while_clock_stretching(void) {
-    /* Maximal timeout of 150ms (SCD30) in sleep polling cycles */
-    uint32_t timeout_cycles = 150000 / SENSIRION_I2C_CLOCK_PERIOD_USEC;
+    uint32_t poll_nsec;
+    uint32_t timeout_cycles;
+    uint32_t polls = 0;
+    int16_t ret;
 
-    while (--timeout_cycles) {
+    poll_nsec = clock_period_nsec;
+    if (poll_nsec < CLOCK_STRETCHING_MIN_POLL_NSEC)
+        poll_nsec = CLOCK_STRETCHING_MIN_POLL_NSEC;
+    timeout_cycles = CLOCK_STRETCHING_TIMEOUT_NSEC / poll_nsec;
+    /* poll at least once with periods above the timeout */
+    if (!timeout_cycles)
+        timeout_cycles = 1;
+
+    while (timeout_cycles--) {
         if (sensirion_i2c_gpio_SCL_read())
             return NO_ERROR;
-        sensirion_i2c_gpio_sleep_usec(SENSIRION_I2C_CLOCK_PERIOD_USEC);
+        /* short stretches are polled, long ones are waited for if the pin
+         * driver can, otherwise polling goes on */
+        if (++polls == CLOCK_STRETCHING_SPIN_POLLS) {
+            ret = sensirion_i2c_gpio_SCL_wait_high(timeout_cycles * poll_nsec /
+                                                   1000);
+            if (ret != NOT_IMPLEMENTED_ERROR)
+                return ret == NO_ERROR ? NO_ERROR : I2C_BUS_ERROR;
+        }
+        sensirion_i2c_gpio_delay_nsec(poll_nsec);
     }
 
     return I2C_BUS_ERROR;
@@ -179,25 +421,25 @@ static int8_t sensirion_wait_while_clock_stretching(void) {
 static int8_t sensirion_i2c_gpio_write_byte(uint8_t data) {
     int8_t nack, i;
     for (i = 7; i >= 0; i--) {
-        sensirion_i2c_gpio_SCL_out();
+        SCL_LOW();
         if ((data >> i) & 0x01)
-            sensirion_i2c_gpio_SDA_in();
+            SDA_RELEASE();
         else
-            sensirion_i2c_gpio_SDA_out();
-        sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
-        sensirion_i2c_gpio_SCL_in();
-        sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
+            SDA_LOW();
+        sensirion_i2c_gpio_delay_nsec(delay_nsec);
+        SCL_RELEASE();
+        sensirion_i2c_gpio_delay_nsec(delay_nsec);
         if (sensirion_wait_while_clock_stretching())
             return I2C_BUS_ERROR;
     }
-    sensirion_i2c_gpio_SCL_out();
-    sensirion_i2c_gpio_SDA_in();
-    sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
-    sensirion_i2c_gpio_SCL_in();
+    SCL_LOW();
+    SDA_RELEASE();
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
+    SCL_RELEASE();
     if (sensirion_wait_while_clock_stretching())
         return I2C_BUS_ERROR;
     nack = (sensirion_i2c_gpio_SDA_read() != 0);
-    sensirion_i2c_gpio_SCL_out();
+    SCL_LOW();
 
     return nack;
 }
@@ -205,47 +447,95 @@ static int8_t sensirion_i2c_gpio_write_byte(uint8_t data) {
 static uint8_t sensirion_i2c_gpio_read_byte(uint8_t ack) {
     int8_t i;
     uint8_t data = 0;
-    sensirion_i2c_gpio_SDA_in();
+    SDA_RELEASE();
     for (i = 7; i >= 0; i--) {
-        sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
-        sensirion_i2c_gpio_SCL_in();
+        sensirion_i2c_gpio_delay_nsec(delay_nsec);
+        SCL_RELEASE();
         if (sensirion_wait_while_clock_stretching())
             return 0xFF; /* return 0xFF on error */
         data |= (sensirion_i2c_gpio_SDA_read() != 0) << i;
-        sensirion_i2c_gpio_SCL_out();
+        SCL_LOW();
     }
     if (ack)
-        sensirion_i2c_gpio_SDA_out();
+        SDA_LOW();
     else
-        sensirion_i2c_gpio_SDA_in();
-    sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
-    sensirion_i2c_gpio_SCL_in();
-    sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
+        SDA_RELEASE();
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
+    SCL_RELEASE();
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
     if (sensirion_wait_while_clock_stretching())
         return 0xFF; /* return 0xFF on error */
-    sensirion_i2c_gpio_SCL_out();
-    sensirion_i2c_gpio_SDA_in();
+    SCL_LOW();
+    SDA_RELEASE();
 
     return data;
 }
 
 static int8_t sensirion_i2c_gpio_start(void) {
-    sensirion_i2c_gpio_SCL_in();
+    /* in case of a repeated start SCL is low after the last byte: release SDA
+     * while SCL is low and keep it low for the minimal low time */
+    SDA_RELEASE();
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
+    SCL_RELEASE();
     if (sensirion_wait_while_clock_stretching())
         return I2C_BUS_ERROR;
 
-    sensirion_i2c_gpio_SDA_out();
-    sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
-    sensirion_i2c_gpio_SCL_out();
-    sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
+    /* setup time in case of a repeated start */
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
+    SDA_LOW();
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
+    SCL_LOW();
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
     return NO_ERROR;
 }
 
 static void sensirion_i2c_gpio_stop(void) {
-    sensirion_i2c_gpio_SDA_out();
-    sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
-    sensirion_i2c_gpio_SCL_in();
-    sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
-    sensirion_i2c_gpio_SDA_in();
-    sensirion_i2c_gpio_sleep_usec(DELAY_USEC);
+    SDA_LOW();
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
+    SCL_RELEASE();
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
+    SDA_RELEASE();
+    sensirion_i2c_gpio_delay_nsec(delay_nsec);
+}
+
+/* start condition and address byte followed by the data, without stop */
+static int8_t sensirion_i2c_gpio_transmit(uint8_t address, const uint8_t* data,
+                                          uint8_t count) {
+    int8_t ret;
+    uint8_t i;
+
+    sensirion_i2c_gpio_select_clock(address);
+    ret = sensirion_i2c_gpio_start();
+    if (ret != NO_ERROR)
+        return ret;
+
+    ret = sensirion_i2c_gpio_write_byte(address << 1);
+    for (i = 0; ret == NO_ERROR && i < count; i++) {
+        ret = sensirion_i2c_gpio_write_byte(data[i]);
+    }
+    return ret;
+}
+
+/* (repeated) start condition and address byte followed by reading the data,
+ * without stop */
+static int8_t sensirion_i2c_gpio_receive(uint8_t address, uint8_t* data,
+                                         uint8_t count) {
+    int8_t ret;
+    uint8_t send_ack;
+    uint8_t i;
+
+    sensirion_i2c_gpio_select_clock(address);
+    ret = sensirion_i2c_gpio_start();
+    if (ret != NO_ERROR)
+        return ret;
+
+    ret = sensirion_i2c_gpio_write_byte((address << 1) | 1);
+    if (ret != NO_ERROR)
+        return ret;
+
+    for (i = 0; i < count; i++) {
+        send_ack = i < (count - 1); /* last byte must be NACK'ed */
+        data[i] = sensirion_i2c_gpio_read_byte(send_ack);
+    }
+    return NO_ERROR;
 }
@@ -101,6 +101,98 @@ int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
                                            (uint8_t*)data, count, 100);
 }
 
+/**
+ * Execute a write transaction followed by a read transaction on the I2C bus
+ * without releasing the bus in between (repeated start), e.g. to send a
+ * command and read its response. If the device does not acknowledge any of
+ * the bytes, an error shall be returned.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR to let the
+ * caller use sensirion_i2c_hal_write() followed by sensirion_i2c_hal_read(),
+ * e.g. on platforms without support for repeated starts.
+ *
+ * @param address  7-bit I2C address to write to and read from
+ * @param tx_data  pointer to the buffer containing the data to write
+ * @param tx_count number of bytes to send over I2C
+ * @param rx_data  pointer to the buffer where the read data is to be stored
+ * @param rx_count number of bytes to read from I2C and store in the buffer
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_write_read(uint8_t address, const uint8_t* tx_data,
+                                    uint8_t tx_count, uint8_t* rx_data,
+                                    uint8_t rx_count) {
+    /* HAL_I2C_Master_Transmit() always ends with a stop condition, there is
+     * no repeated start */
+    return NOT_IMPLEMENTED_ERROR;
+}
+
+/**
+ * Execute a list of transfers, possibly to different addresses, with as
+ * little overhead between them as the platform allows. The error member of
+ * every transfer must be set to 0 on success and to an error code otherwise.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR without touching
+ * the transfers to let the caller execute them one by one.
+ *
+ * @param transfers list of transfers to execute
+ * @param count     number of transfers in the list
+ * @returns 0 if all transfers succeeded, error code otherwise
+ */
+int8_t sensirion_i2c_hal_transfer(struct sensirion_i2c_hal_transfer* transfers,
+                                  uint16_t count) {
+    return NOT_IMPLEMENTED_ERROR; /* executed one by one by sensirion_i2c */
+}
+
+/**
+ * Single-bus implementation of the bus functions: the bus handle is ignored
+ * and all transfers are executed on the default bus.
+ */
+int16_t sensirion_i2c_hal_bus_init(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t bus_idx) {
+    bus->bus_idx = bus_idx;
+    bus->handle = 0;
+    bus->address = 0;
+    return NO_ERROR;
+}
+
+void sensirion_i2c_hal_bus_free(struct sensirion_i2c_hal_bus* bus) {
+}
+
+int8_t sensirion_i2c_hal_bus_read(struct sensirion_i2c_hal_bus* bus,
+                                  uint8_t address, uint8_t* data,
+                                  uint8_t count) {
+    return sensirion_i2c_hal_read(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_bus_write(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t address, const uint8_t* data,
+                                   uint8_t count) {
+    return sensirion_i2c_hal_write(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_bus_write_read(struct sensirion_i2c_hal_bus* bus,
+                                        uint8_t address, const uint8_t* tx_data,
+                                        uint8_t tx_count, uint8_t* rx_data,
+                                        uint8_t rx_count) {
+    return sensirion_i2c_hal_write_read(address, tx_data, tx_count, rx_data,
+                                        rx_count);
+}
+
+int8_t
+sensirion_i2c_hal_bus_transfer(struct sensirion_i2c_hal_bus* bus,
+                               struct sensirion_i2c_hal_transfer* transfers,
+                               uint16_t count) {
+    return sensirion_i2c_hal_transfer(transfers, count);
+}
+
+/**
+ * Return a monotonic timestamp in microseconds.
+ */
+uint32_t sensirion_i2c_hal_get_time_usec(void) {
+    /* millisecond resolution, wraps consistently modulo 2^32 */
+    return HAL_GetTick() * 1000;
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution for at least the given time, but may also sleep longer.
@@ -37,46 +37,140 @@
 #include "sensirion_config.h"
 
 #include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
 #include <stdio.h>
 #include <sys/ioctl.h>
+#include <time.h>
 #include <unistd.h>
 
 /**
- * Linux specific configuration. Adjust the following define to the device path
- * of your sensor.
+ * Linux specific configuration. Adjust the following define to the bus index
+ * of your sensor, i.e. N of the device path /dev/i2c-N. Other buses can be
+ * selected with sensirion_i2c_hal_select_bus() for indices below
+ * I2C_MAX_BUSES.
  */
-#define I2C_DEVICE_PATH "/dev/i2c-1"
+#define I2C_DEFAULT_BUS_IDX 1
+#define I2C_MAX_BUSES 16
+#define I2C_DEVICE_PATH_PREFIX "/dev/i2c-"
+
+#define I2C_SELECT_BUS_FAILED -1
+#define I2C_OPEN_FAILED -1
+#define I2C_WRITE_FAILED -1
+#define I2C_READ_FAILED -1
+#define I2C_WRITE_READ_FAILED -1
+
+/* not a valid 7-bit address, forces an I2C_SLAVE ioctl on the next transfer */
+#define I2C_NO_ADDRESS 0xFF
+
+/*
+ * Buses used through sensirion_i2c_hal_select_bus(), indexed by bus index.
+ * Every bus is opened on first use and stays open until
+ * sensirion_i2c_hal_free(), so switching buses only changes selected_bus.
+ */
+static struct sensirion_i2c_hal_bus bus_cache[I2C_MAX_BUSES];
+static bool bus_cache_initialized = false;
+static uint8_t selected_bus = I2C_DEFAULT_BUS_IDX;
+
+static void sensirion_i2c_hal_init_bus_cache(void) {
+    uint8_t i;
+
+    for (i = 0; i < I2C_MAX_BUSES; ++i) {
+        bus_cache[i].bus_idx = i;
+        bus_cache[i].handle = -1;
+        bus_cache[i].address = I2C_NO_ADDRESS;
+    }
+    bus_cache_initialized = true;
+}
+
+static struct sensirion_i2c_hal_bus*
+sensirion_i2c_hal_get_bus(struct sensirion_i2c_hal_bus* bus) {
+    if (bus)
+        return bus;
+    if (!bus_cache_initialized)
+        sensirion_i2c_hal_init_bus_cache();
+    return &bus_cache[selected_bus];
+}
+
+/* select the slave address for read() and write() on the bus */
+static void sensirion_i2c_hal_set_address(struct sensirion_i2c_hal_bus* bus,
+                                          uint8_t address) {
+    if (bus->address != address) {
+        ioctl(bus->handle, I2C_SLAVE, address);
+        bus->address = address;
+    }
+}
+
+/* append the messages of one transfer to the I2C_RDWR message list */
+static void
+sensirion_i2c_hal_add_messages(struct i2c_rdwr_ioctl_data* ioctl_data,
+                               const struct sensirion_i2c_hal_transfer* t) {
+    struct i2c_msg* message;
+
+    if (t->tx_count) {
+        message = &ioctl_data->msgs[ioctl_data->nmsgs++];
+        message->addr = t->address;
+        message->flags = 0;
+        message->len = t->tx_count;
+        message->buf = (uint8_t*)t->tx_data;
+    }
+    if (t->rx_count) {
+        message = &ioctl_data->msgs[ioctl_data->nmsgs++];
+        message->addr = t->address;
+        message->flags = I2C_M_RD;
+        message->len = t->rx_count;
+        message->buf = t->rx_data;
+    }
+}
 
 /**
- * The following define was taken from i2c-dev.h. Alternatively the header file
- * can be included. The define was added in Linux v3.10 and never changed since
- * then.
+ * Select the current i2c bus by index.
+ * All following i2c operations will be directed at that bus.
+ *
+ * The bus /dev/i2c-<bus_idx> is opened when it is selected for the first time
+ * and stays open, selecting it again does not access the device.
+ *
+ * @param bus_idx   Bus index to select
+ * @returns         0 on success, an error code otherwise
  */
-#define I2C_SLAVE 0x0703
+int16_t sensirion_i2c_hal_select_bus(uint8_t bus_idx) {
+    struct sensirion_i2c_hal_bus* bus;
+    int16_t ret;
 
-#define I2C_WRITE_FAILED -1
-#define I2C_READ_FAILED -1
+    if (bus_idx >= I2C_MAX_BUSES)
+        return I2C_SELECT_BUS_FAILED;
+    if (!bus_cache_initialized)
+        sensirion_i2c_hal_init_bus_cache();
 
-static int i2c_device = -1;
-static uint8_t i2c_address = 0;
+    bus = &bus_cache[bus_idx];
+    if (bus->handle == -1) {
+        ret = sensirion_i2c_hal_bus_init(bus, bus_idx);
+        if (ret)
+            return ret;
+    }
+    selected_bus = bus_idx;
+    return 0;
+}
 
 /**
  * Initialize all hard- and software components that are needed for the I2C
  * communication.
  */
 void sensirion_i2c_hal_init(void) {
-    /* open i2c adapter */
-    i2c_device = open(I2C_DEVICE_PATH, O_RDWR);
-    if (i2c_device == -1)
-        return; /* no error handling */
+    /* no error handling */
+    sensirion_i2c_hal_select_bus(selected_bus);
 }
 
 /**
  * Release all resources initialized by sensirion_i2c_hal_init().
  */
 void sensirion_i2c_hal_free(void) {
-    if (i2c_device >= 0)
-        close(i2c_device);
+    uint8_t i;
+
+    if (!bus_cache_initialized)
+        return;
+    for (i = 0; i < I2C_MAX_BUSES; ++i)
+        sensirion_i2c_hal_bus_free(&bus_cache[i]);
 }
 
 /**
@@ -90,15 +184,7 @@ void sensirion_i2c_hal_free(void) {
  * @returns 0 on success, error code otherwise
  */
 int8_t sensirion_i2c_hal_read(uint8_t address, uint8_t* data, uint8_t count) {
-    if (i2c_address != address) {
-        ioctl(i2c_device, I2C_SLAVE, address);
-        i2c_address = address;
-    }
-
-    if (read(i2c_device, data, count) != count) {
-        return I2C_READ_FAILED;
-    }
-    return 0;
+    return sensirion_i2c_hal_bus_read(NULL, address, data, count);
 }
 
 /**
@@ -114,17 +200,224 @@ int8_t sensirion_i2c_hal_read(uint8_t address, uint8_t* data, uint8_t count) {
  */
 int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
                                uint8_t count) {
-    if (i2c_address != address) {
-        ioctl(i2c_device, I2C_SLAVE, address);
-        i2c_address = address;
+    return sensirion_i2c_hal_bus_write(NULL, address, data, count);
+}
+
+/**
+ * Execute a write transaction followed by a read transaction on the I2C bus
+ * without releasing the bus in between (repeated start), e.g. to send a
+ * command and read its response. If the device does not acknowledge any of
+ * the bytes, an error shall be returned.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR to let the
+ * caller use sensirion_i2c_hal_write() followed by sensirion_i2c_hal_read(),
+ * e.g. on platforms without support for repeated starts.
+ *
+ * @param address  7-bit I2C address to write to and read from
+ * @param tx_data  pointer to the buffer containing the data to write
+ * @param tx_count number of bytes to send over I2C
+ * @param rx_data  pointer to the buffer where the read data is to be stored
+ * @param rx_count number of bytes to read from I2C and store in the buffer
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_write_read(uint8_t address, const uint8_t* tx_data,
+                                    uint8_t tx_count, uint8_t* rx_data,
+                                    uint8_t rx_count) {
+    return sensirion_i2c_hal_bus_write_read(NULL, address, tx_data, tx_count,
+                                            rx_data, rx_count);
+}
+
+/**
+ * Execute a list of transfers, possibly to different addresses, with as
+ * little overhead between them as the platform allows. The error member of
+ * every transfer must be set to 0 on success and to an error code otherwise.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR without touching
+ * the transfers to let the caller execute them one by one.
+ *
+ * @param transfers list of transfers to execute
+ * @param count     number of transfers in the list
+ * @returns 0 if all transfers succeeded, error code otherwise
+ */
+int8_t sensirion_i2c_hal_transfer(struct sensirion_i2c_hal_transfer* transfers,
+                                  uint16_t count) {
+    return sensirion_i2c_hal_bus_transfer(NULL, transfers, count);
+}
+
+/**
+ * Initialize a bus handle for the bus with the given index and all hard- and
+ * software components that are needed to communicate on it.
+ *
+ * @param bus     bus handle to initialize
+ * @param bus_idx index N of the I2C adapter /dev/i2c-N
+ * @returns 0 on success, error code otherwise
+ */
+int16_t sensirion_i2c_hal_bus_init(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t bus_idx) {
+    char path[sizeof(I2C_DEVICE_PATH_PREFIX) + 3];
+
+    sprintf(path, I2C_DEVICE_PATH_PREFIX "%u", (unsigned)bus_idx);
+    bus->bus_idx = bus_idx;
+    bus->address = I2C_NO_ADDRESS;
+    bus->handle = open(path, O_RDWR);
+    if (bus->handle == -1)
+        return I2C_OPEN_FAILED;
+    return 0;
+}
+
+/**
+ * Release all resources initialized by sensirion_i2c_hal_bus_init().
+ *
+ * @param bus bus handle to release
+ */
+void sensirion_i2c_hal_bus_free(struct sensirion_i2c_hal_bus* bus) {
+    if (bus->handle >= 0)
+        close(bus->handle);
+    bus->handle = -1;
+}
+
+/**
+ * Same as sensirion_i2c_hal_read() on the given bus.
+ *
+ * @param bus     bus handle or NULL for the default bus
+ * @param address 7-bit I2C address to read from
+ * @param data    pointer to the buffer where the data is to be stored
+ * @param count   number of bytes to read from I2C and store in the buffer
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_bus_read(struct sensirion_i2c_hal_bus* bus,
+                                  uint8_t address, uint8_t* data,
+                                  uint8_t count) {
+    bus = sensirion_i2c_hal_get_bus(bus);
+    sensirion_i2c_hal_set_address(bus, address);
+
+    if (read(bus->handle, data, count) != count) {
+        return I2C_READ_FAILED;
     }
+    return 0;
+}
+
+/**
+ * Same as sensirion_i2c_hal_write() on the given bus.
+ *
+ * @param bus     bus handle or NULL for the default bus
+ * @param address 7-bit I2C address to write to
+ * @param data    pointer to the buffer containing the data to write
+ * @param count   number of bytes to read from the buffer and send over I2C
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_bus_write(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t address, const uint8_t* data,
+                                   uint8_t count) {
+    bus = sensirion_i2c_hal_get_bus(bus);
+    sensirion_i2c_hal_set_address(bus, address);
 
-    if (write(i2c_device, data, count) != count) {
+    if (write(bus->handle, data, count) != count) {
         return I2C_WRITE_FAILED;
     }
     return 0;
 }
 
+/**
+ * Same as sensirion_i2c_hal_write_read() on the given bus.
+ *
+ * @param bus      bus handle or NULL for the default bus
+ * @param address  7-bit I2C address to write to and read from
+ * @param tx_data  pointer to the buffer containing the data to write
+ * @param tx_count number of bytes to send over I2C
+ * @param rx_data  pointer to the buffer where the read data is to be stored
+ * @param rx_count number of bytes to read from I2C and store in the buffer
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_bus_write_read(struct sensirion_i2c_hal_bus* bus,
+                                        uint8_t address, const uint8_t* tx_data,
+                                        uint8_t tx_count, uint8_t* rx_data,
+                                        uint8_t rx_count) {
+    struct i2c_msg messages[2];
+    struct i2c_rdwr_ioctl_data transfer;
+
+    bus = sensirion_i2c_hal_get_bus(bus);
+
+    /* I2C_RDWR carries the address in the messages, no I2C_SLAVE needed */
+    messages[0].addr = address;
+    messages[0].flags = 0;
+    messages[0].len = tx_count;
+    messages[0].buf = (uint8_t*)tx_data;
+    messages[1].addr = address;
+    messages[1].flags = I2C_M_RD;
+    messages[1].len = rx_count;
+    messages[1].buf = rx_data;
+
+    transfer.msgs = messages;
+    transfer.nmsgs = 2;
+
+    if (ioctl(bus->handle, I2C_RDWR, &transfer) != 2) {
+        return I2C_WRITE_READ_FAILED;
+    }
+    return 0;
+}
+
+/**
+ * Same as sensirion_i2c_hal_transfer() on the given bus.
+ *
+ * @param bus       bus handle or NULL for the default bus
+ * @param transfers list of transfers to execute
+ * @param count     number of transfers in the list
+ * @returns 0 if all transfers succeeded, error code otherwise
+ */
+int8_t
+sensirion_i2c_hal_bus_transfer(struct sensirion_i2c_hal_bus* bus,
+                               struct sensirion_i2c_hal_transfer* transfers,
+                               uint16_t count) {
+    struct i2c_msg messages[I2C_RDWR_IOCTL_MAX_MSGS];
+    struct i2c_rdwr_ioctl_data ioctl_data;
+    uint16_t first = 0;
+    uint16_t last;
+    uint16_t i;
+    int8_t error;
+    int8_t ret = 0;
+
+    bus = sensirion_i2c_hal_get_bus(bus);
+
+    while (first < count) {
+        /* pack as many transfers as possible into one I2C_RDWR ioctl */
+        ioctl_data.msgs = messages;
+        ioctl_data.nmsgs = 0;
+        for (last = first; last < count; ++last) {
+            if (ioctl_data.nmsgs + 2 > I2C_RDWR_IOCTL_MAX_MSGS)
+                break;
+            sensirion_i2c_hal_add_messages(&ioctl_data, &transfers[last]);
+        }
+
+        /*
+         * The kernel does not report which message failed and has already
+         * executed the messages before it. Repeating them would send these
+         * commands twice, so all transfers of a failed ioctl get the error.
+         */
+        error = 0;
+        if (ioctl(bus->handle, I2C_RDWR, &ioctl_data) !=
+            (int)ioctl_data.nmsgs) {
+            error = I2C_WRITE_READ_FAILED;
+            ret = I2C_WRITE_READ_FAILED;
+        }
+        for (i = first; i < last; ++i)
+            transfers[i].error = error;
+        first = last;
+    }
+    return ret;
+}
+
+/**
+ * Return a monotonic timestamp in microseconds. The resolution is one
+ * microsecond, so SENSIRION_I2C_HAL_TIME_RESOLUTION_USEC can be set to 1.
+ */
+uint32_t sensirion_i2c_hal_get_time_usec(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec * 1000000 + (uint32_t)now.tv_nsec / 1000;
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution for at least the given time, but may also sleep longer.
@@ -34,20 +34,109 @@
 #include "sensirion_config.h"
 #include "sensirion_i2c_hal.h"
 
+#if SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_NIBBLE_TABLE
+/* CRC of the upper nibble of the index shifted through the polynomial */
+static const uint8_t sensirion_i2c_crc_nibble_table[16] = {
+    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
+    0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+};
+#elif SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_BYTE_TABLE || \
+    SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_WORD_TABLE
+/* CRC of the index shifted through the polynomial */
+static const uint8_t sensirion_i2c_crc_byte_table[256] = {
+    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
+    0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+    0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4,
+    0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+    0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11,
+    0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+    0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52,
+    0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+    0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA,
+    0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+    0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9,
+    0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+    0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C,
+    0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+    0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F,
+    0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+    0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED,
+    0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+    0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE,
+    0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+    0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B,
+    0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+    0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28,
+    0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+    0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0,
+    0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+    0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93,
+    0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+    0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56,
+    0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+    0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15,
+    0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC,
+};
+#endif
+
+#if SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_WORD_TABLE
+/* CRC of a whole data word (MSB first), including the CRC8_INIT value, filled
+ * by sensirion_i2c_crc_init() */
+static uint8_t sensirion_i2c_crc_word_table[1UL << 16];
+static bool sensirion_i2c_crc_word_table_ready = false;
+#endif
+
+void sensirion_i2c_crc_init(void) {
+#if SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_WORD_TABLE
+    uint16_t msb;
+    uint16_t lsb;
+    uint8_t crc;
+
+    if (sensirion_i2c_crc_word_table_ready)
+        return;
+    for (msb = 0; msb < 256; ++msb) {
+        crc = sensirion_i2c_crc_byte_table[CRC8_INIT ^ msb];
+        for (lsb = 0; lsb < 256; ++lsb) {
+            sensirion_i2c_crc_word_table[(msb << 8) | lsb] =
+                sensirion_i2c_crc_byte_table[crc ^ lsb];
+        }
+    }
+    sensirion_i2c_crc_word_table_ready = true;
+#endif
+}
+
 uint8_t sensirion_i2c_generate_crc(const uint8_t* data, uint16_t count) {
     uint16_t current_byte;
     uint8_t crc = CRC8_INIT;
+#if SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_BITWISE
     uint8_t crc_bit;
+#endif
+
+#if SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_WORD_TABLE
+    /* the byte table is used until sensirion_i2c_crc_init() is called */
+    if (count == SENSIRION_WORD_SIZE && sensirion_i2c_crc_word_table_ready) {
+        return sensirion_i2c_crc_word_table[((uint16_t)data[0] << 8) |
+                                            data[1]];
+    }
+#endif
 
     /* calculates 8-Bit checksum with given polynomial */
     for (current_byte = 0; current_byte < count; ++current_byte) {
         crc ^= (data[current_byte]);
+#if SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_NIBBLE_TABLE
+        crc = (uint8_t)(crc << 4) ^ sensirion_i2c_crc_nibble_table[crc >> 4];
+        crc = (uint8_t)(crc << 4) ^ sensirion_i2c_crc_nibble_table[crc >> 4];
+#elif SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_BYTE_TABLE || \
+    SENSIRION_I2C_CRC_ENGINE == SENSIRION_I2C_CRC_ENGINE_WORD_TABLE
+        crc = sensirion_i2c_crc_byte_table[crc];
+#else
         for (crc_bit = 8; crc_bit > 0; --crc_bit) {
             if (crc & 0x80)
                 crc = (crc << 1) ^ CRC8_POLYNOMIAL;
             else
                 crc = (crc << 1);
         }
+#endif
     }
     return crc;
 }
@@ -59,9 +148,62 @@ int8_t sensirion_i2c_check_crc(const uint8_t* data, uint16_t count,
     return NO_ERROR;
 }
 
+int16_t sensirion_i2c_verify_and_compact(const uint8_t* src, uint8_t* dst,
+                                         uint16_t num_words,
+                                         uint8_t* crc_error_mask) {
+    uint16_t i;
+    uint8_t msb;
+    uint8_t lsb;
+    uint8_t failed;
+    uint8_t any_failed = 0;
+    uint8_t mask = 0;
+
+    for (i = 0; i < num_words; ++i) {
+        /* read the whole triplet first since dst may overlap src */
+        msb = src[0];
+        lsb = src[1];
+        failed = sensirion_i2c_generate_crc(src, SENSIRION_WORD_SIZE) != src[2];
+        src += SENSIRION_WORD_SIZE + CRC8_LEN;
+
+        *(dst++) = msb;
+        *(dst++) = lsb;
+
+        any_failed |= failed;
+        mask |= (uint8_t)(failed << (i % 8));
+        if (i % 8 == 7 || i == num_words - 1) {
+            if (crc_error_mask)
+                crc_error_mask[i / 8] = mask;
+            mask = 0;
+        }
+    }
+
+    if (any_failed)
+        return CRC_ERROR;
+    return NO_ERROR;
+}
+
+uint16_t sensirion_i2c_expand_with_crc(const uint8_t* src, uint8_t* dst,
+                                       uint16_t num_words) {
+    uint16_t i;
+
+    for (i = 0; i < num_words; ++i) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = sensirion_i2c_generate_crc(src, SENSIRION_WORD_SIZE);
+        src += SENSIRION_WORD_SIZE;
+        dst += SENSIRION_WORD_SIZE + CRC8_LEN;
+    }
+    return num_words * (SENSIRION_WORD_SIZE + CRC8_LEN);
+}
+
 int16_t sensirion_i2c_general_call_reset(void) {
+    return sensirion_i2c_bus_general_call_reset(NULL);
+}
+
+int16_t
+sensirion_i2c_bus_general_call_reset(struct sensirion_i2c_hal_bus* bus) {
     const uint8_t data = 0x06;
-    return sensirion_i2c_hal_write(0, &data, (uint16_t)sizeof(data));
+    return sensirion_i2c_hal_bus_write(bus, 0, &data, (uint16_t)sizeof(data));
 }
 
 uint16_t sensirion_i2c_fill_cmd_send_buf(uint8_t* buf, uint16_t cmd,
@@ -84,90 +226,220 @@ uint16_t sensirion_i2c_fill_cmd_send_buf(uint8_t* buf, uint16_t cmd,
     return idx;
 }
 
-int16_t sensirion_i2c_read_words_as_bytes(uint8_t address, uint8_t* data,
-                                          uint16_t num_words) {
+/* write followed by read with a repeated start, or as two transactions if the
+ * HAL does not implement sensirion_i2c_hal_write_read() */
+static int8_t sensirion_i2c_write_read(struct sensirion_i2c_hal_bus* bus,
+                                       uint8_t address, const uint8_t* tx_data,
+                                       uint8_t tx_count, uint8_t* rx_data,
+                                       uint8_t rx_count) {
+    int8_t ret;
+
+    ret = sensirion_i2c_hal_bus_write_read(bus, address, tx_data, tx_count,
+                                           rx_data, rx_count);
+    if (ret != NOT_IMPLEMENTED_ERROR)
+        return ret;
+
+    ret = sensirion_i2c_hal_bus_write(bus, address, tx_data, tx_count);
+    if (ret != NO_ERROR)
+        return ret;
+    return sensirion_i2c_hal_bus_read(bus, address, rx_data, rx_count);
+}
+
+/* read num_words words, preceded by a write of tx_length bytes with a
+ * repeated start unless tx_length is 0 */
+static int16_t sensirion_i2c_transceive_words(struct sensirion_i2c_hal_bus* bus,
+                                              uint8_t address,
+                                              const uint8_t* tx_data,
+                                              uint16_t tx_length, uint8_t* data,
+                                              uint16_t num_words) {
     int16_t ret;
-    uint16_t i, j;
     uint16_t size = num_words * (SENSIRION_WORD_SIZE + CRC8_LEN);
     uint16_t word_buf[SENSIRION_MAX_BUFFER_WORDS];
     uint8_t* const buf8 = (uint8_t*)word_buf;
 
-    ret = sensirion_i2c_hal_read(address, buf8, size);
+    if (tx_length)
+        ret = sensirion_i2c_write_read(bus, address, tx_data,
+                                       (uint8_t)tx_length, buf8, (uint8_t)size);
+    else
+        ret = sensirion_i2c_hal_bus_read(bus, address, buf8, (uint8_t)size);
     if (ret != NO_ERROR)
         return ret;
 
-    /* check the CRC for each word */
-    for (i = 0, j = 0; i < size; i += SENSIRION_WORD_SIZE + CRC8_LEN) {
+    return sensirion_i2c_verify_and_compact(buf8, data, num_words, NULL);
+}
 
-        ret = sensirion_i2c_check_crc(&buf8[i], SENSIRION_WORD_SIZE,
-                                      buf8[i + SENSIRION_WORD_SIZE]);
-        if (ret != NO_ERROR)
-            return ret;
+/* convert words received as big-endian byte stream to the uP's word-order */
+static void sensirion_i2c_bytes_to_words(uint16_t* data_words,
+                                         uint16_t num_words) {
+    uint16_t i;
 
-        data[j++] = buf8[i];
-        data[j++] = buf8[i + 1];
+    for (i = 0; i < num_words; ++i) {
+        const uint8_t* word_bytes = (uint8_t*)&data_words[i];
+        data_words[i] = ((uint16_t)word_bytes[0] << 8) | word_bytes[1];
     }
+}
 
-    return NO_ERROR;
+int16_t sensirion_i2c_read_words_as_bytes(uint8_t address, uint8_t* data,
+                                          uint16_t num_words) {
+    return sensirion_i2c_bus_read_words_as_bytes(NULL, address, data,
+                                                 num_words);
+}
+
+int16_t sensirion_i2c_bus_read_words_as_bytes(struct sensirion_i2c_hal_bus* bus,
+                                              uint8_t address, uint8_t* data,
+                                              uint16_t num_words) {
+    return sensirion_i2c_transceive_words(bus, address, NULL, 0, data,
+                                          num_words);
 }
 
 int16_t sensirion_i2c_read_words(uint8_t address, uint16_t* data_words,
                                  uint16_t num_words) {
+    return sensirion_i2c_bus_read_words(NULL, address, data_words, num_words);
+}
+
+int16_t sensirion_i2c_bus_read_words(struct sensirion_i2c_hal_bus* bus,
+                                     uint8_t address, uint16_t* data_words,
+                                     uint16_t num_words) {
     int16_t ret;
-    uint8_t i;
 
-    ret = sensirion_i2c_read_words_as_bytes(address, (uint8_t*)data_words,
-                                            num_words);
+    ret = sensirion_i2c_bus_read_words_as_bytes(
+        bus, address, (uint8_t*)data_words, num_words);
     if (ret != NO_ERROR)
         return ret;
 
-    for (i = 0; i < num_words; ++i) {
-        const uint8_t* word_bytes = (uint8_t*)&data_words[i];
-        data_words[i] = ((uint16_t)word_bytes[0] << 8) | word_bytes[1];
-    }
-
+    sensirion_i2c_bytes_to_words(data_words, num_words);
     return NO_ERROR;
 }
 
 int16_t sensirion_i2c_write_cmd(uint8_t address, uint16_t command) {
+    return sensirion_i2c_bus_write_cmd(NULL, address, command);
+}
+
+int16_t sensirion_i2c_bus_write_cmd(struct sensirion_i2c_hal_bus* bus,
+                                    uint8_t address, uint16_t command) {
     uint8_t buf[SENSIRION_COMMAND_SIZE];
 
     sensirion_i2c_fill_cmd_send_buf(buf, command, NULL, 0);
-    return sensirion_i2c_hal_write(address, buf, SENSIRION_COMMAND_SIZE);
+    return sensirion_i2c_hal_bus_write(bus, address, buf,
+                                       SENSIRION_COMMAND_SIZE);
 }
 
 int16_t sensirion_i2c_write_cmd_with_args(uint8_t address, uint16_t command,
                                           const uint16_t* data_words,
                                           uint16_t num_words) {
+    return sensirion_i2c_bus_write_cmd_with_args(NULL, address, command,
+                                                 data_words, num_words);
+}
+
+int16_t sensirion_i2c_bus_write_cmd_with_args(struct sensirion_i2c_hal_bus* bus,
+                                              uint8_t address, uint16_t command,
+                                              const uint16_t* data_words,
+                                              uint16_t num_words) {
     uint8_t buf[SENSIRION_MAX_BUFFER_WORDS];
     uint16_t buf_size;
 
     buf_size =
         sensirion_i2c_fill_cmd_send_buf(buf, command, data_words, num_words);
-    return sensirion_i2c_hal_write(address, buf, buf_size);
+    return sensirion_i2c_hal_bus_write(bus, address, buf, buf_size);
 }
 
 int16_t sensirion_i2c_delayed_read_cmd(uint8_t address, uint16_t cmd,
                                        uint32_t delay_us, uint16_t* data_words,
                                        uint16_t num_words) {
+    return sensirion_i2c_bus_delayed_read_cmd(NULL, address, cmd, delay_us,
+                                              data_words, num_words);
+}
+
+int16_t sensirion_i2c_bus_delayed_read_cmd(struct sensirion_i2c_hal_bus* bus,
+                                           uint8_t address, uint16_t cmd,
+                                           uint32_t delay_us,
+                                           uint16_t* data_words,
+                                           uint16_t num_words) {
     int16_t ret;
     uint8_t buf[SENSIRION_COMMAND_SIZE];
 
     sensirion_i2c_fill_cmd_send_buf(buf, cmd, NULL, 0);
-    ret = sensirion_i2c_hal_write(address, buf, SENSIRION_COMMAND_SIZE);
+
+    if (!delay_us) {
+        ret = sensirion_i2c_transceive_words(bus, address, buf,
+                                             SENSIRION_COMMAND_SIZE,
+                                             (uint8_t*)data_words, num_words);
+        if (ret != NO_ERROR)
+            return ret;
+
+        sensirion_i2c_bytes_to_words(data_words, num_words);
+        return NO_ERROR;
+    }
+
+    ret = sensirion_i2c_hal_bus_write(bus, address, buf,
+                                      SENSIRION_COMMAND_SIZE);
     if (ret != NO_ERROR)
         return ret;
 
-    if (delay_us)
-        sensirion_i2c_hal_sleep_usec(delay_us);
+    sensirion_i2c_hal_sleep_usec(delay_us);
 
-    return sensirion_i2c_read_words(address, data_words, num_words);
+    return sensirion_i2c_bus_read_words(bus, address, data_words, num_words);
 }
 
 int16_t sensirion_i2c_read_cmd(uint8_t address, uint16_t cmd,
                                uint16_t* data_words, uint16_t num_words) {
-    return sensirion_i2c_delayed_read_cmd(address, cmd, 0, data_words,
-                                          num_words);
+    return sensirion_i2c_bus_delayed_read_cmd(NULL, address, cmd, 0,
+                                              data_words, num_words);
+}
+
+int16_t sensirion_i2c_bus_read_cmd(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t address, uint16_t cmd,
+                                   uint16_t* data_words, uint16_t num_words) {
+    return sensirion_i2c_bus_delayed_read_cmd(bus, address, cmd, 0,
+                                              data_words, num_words);
+}
+
+int16_t sensirion_i2c_issue_cmd(uint8_t address, uint16_t cmd,
+                                uint32_t delay_us, uint32_t* ready_at_us) {
+    return sensirion_i2c_bus_issue_cmd(NULL, address, cmd, delay_us,
+                                       ready_at_us);
+}
+
+int16_t sensirion_i2c_bus_issue_cmd(struct sensirion_i2c_hal_bus* bus,
+                                    uint8_t address, uint16_t cmd,
+                                    uint32_t delay_us, uint32_t* ready_at_us) {
+    int16_t ret;
+
+    ret = sensirion_i2c_bus_write_cmd(bus, address, cmd);
+    if (ret != NO_ERROR)
+        return ret;
+
+    /* the clock may tick right after the command was sent */
+    *ready_at_us = sensirion_i2c_hal_get_time_usec() + delay_us +
+                   SENSIRION_I2C_HAL_TIME_RESOLUTION_USEC;
+    return NO_ERROR;
+}
+
+int16_t sensirion_i2c_fetch_words(uint8_t address, uint32_t ready_at_us,
+                                  uint16_t* data_words, uint16_t num_words) {
+    return sensirion_i2c_bus_fetch_words(NULL, address, ready_at_us,
+                                         data_words, num_words);
+}
+
+int16_t sensirion_i2c_bus_fetch_words(struct sensirion_i2c_hal_bus* bus,
+                                      uint8_t address, uint32_t ready_at_us,
+                                      uint16_t* data_words,
+                                      uint16_t num_words) {
+    uint32_t remaining = sensirion_i2c_remaining_usec(ready_at_us);
+
+    if (remaining)
+        sensirion_i2c_hal_sleep_usec(remaining);
+
+    return sensirion_i2c_bus_read_words(bus, address, data_words, num_words);
+}
+
+uint32_t sensirion_i2c_remaining_usec(uint32_t ready_at_us) {
+    /* the difference is negative once ready_at_us has passed, also when the
+     * timestamps wrapped around in between */
+    int32_t remaining =
+        (int32_t)(ready_at_us - sensirion_i2c_hal_get_time_usec());
+
+    return remaining > 0 ? (uint32_t)remaining : 0;
 }
 
 uint16_t sensirion_i2c_add_command_to_buffer(uint8_t* buffer, uint16_t offset,
@@ -240,33 +512,36 @@ uint16_t sensirion_i2c_add_float_to_buffer(uint8_t* buffer, uint16_t offset,
 uint16_t sensirion_i2c_add_bytes_to_buffer(uint8_t* buffer, uint16_t offset,
                                            const uint8_t* data,
                                            uint16_t data_length) {
-    uint16_t i;
-
     if (data_length % SENSIRION_WORD_SIZE != 0) {
         return BYTE_NUM_ERROR;
     }
 
-    for (i = 0; i < data_length; i += 2) {
-        buffer[offset++] = data[i];
-        buffer[offset++] = data[i + 1];
-
-        buffer[offset] = sensirion_i2c_generate_crc(
-            &buffer[offset - SENSIRION_WORD_SIZE], SENSIRION_WORD_SIZE);
-        offset++;
-    }
-
-    return offset;
+    return offset + sensirion_i2c_expand_with_crc(
+                        data, &buffer[offset],
+                        data_length / SENSIRION_WORD_SIZE);
 }
 
 int16_t sensirion_i2c_write_data(uint8_t address, const uint8_t* data,
                                  uint16_t data_length) {
-    return sensirion_i2c_hal_write(address, data, data_length);
+    return sensirion_i2c_hal_bus_write(NULL, address, data, data_length);
+}
+
+int16_t sensirion_i2c_bus_write_data(struct sensirion_i2c_hal_bus* bus,
+                                     uint8_t address, const uint8_t* data,
+                                     uint16_t data_length) {
+    return sensirion_i2c_hal_bus_write(bus, address, data, data_length);
 }
 
 int16_t sensirion_i2c_read_data_inplace(uint8_t address, uint8_t* buffer,
                                         uint16_t expected_data_length) {
+    return sensirion_i2c_bus_read_data_inplace(NULL, address, buffer,
+                                               expected_data_length);
+}
+
+int16_t sensirion_i2c_bus_read_data_inplace(struct sensirion_i2c_hal_bus* bus,
+                                            uint8_t address, uint8_t* buffer,
+                                            uint16_t expected_data_length) {
     int16_t error;
-    uint16_t i, j;
     uint16_t size = (expected_data_length / SENSIRION_WORD_SIZE) *
                     (SENSIRION_WORD_SIZE + CRC8_LEN);
 
@@ -274,21 +549,132 @@ int16_t sensirion_i2c_read_data_inplace(uint8_t address, uint8_t* buffer,
         return BYTE_NUM_ERROR;
     }
 
-    error = sensirion_i2c_hal_read(address, buffer, size);
+    error = sensirion_i2c_hal_bus_read(bus, address, buffer, size);
     if (error) {
         return error;
     }
 
-    for (i = 0, j = 0; i < size; i += SENSIRION_WORD_SIZE + CRC8_LEN) {
+    return sensirion_i2c_verify_and_compact(
+        buffer, buffer, expected_data_length / SENSIRION_WORD_SIZE, NULL);
+}
 
-        error = sensirion_i2c_check_crc(&buffer[i], SENSIRION_WORD_SIZE,
-                                        buffer[i + SENSIRION_WORD_SIZE]);
-        if (error) {
-            return error;
-        }
-        buffer[j++] = buffer[i];
-        buffer[j++] = buffer[i + 1];
+int16_t sensirion_i2c_write_read_data_inplace(uint8_t address,
+                                              const uint8_t* tx_data,
+                                              uint16_t tx_length,
+                                              uint8_t* buffer,
+                                              uint16_t expected_data_length) {
+    return sensirion_i2c_bus_write_read_data_inplace(
+        NULL, address, tx_data, tx_length, buffer, expected_data_length);
+}
+
+int16_t sensirion_i2c_bus_write_read_data_inplace(
+    struct sensirion_i2c_hal_bus* bus, uint8_t address, const uint8_t* tx_data,
+    uint16_t tx_length, uint8_t* buffer, uint16_t expected_data_length) {
+    int16_t error;
+    uint16_t size = (expected_data_length / SENSIRION_WORD_SIZE) *
+                    (SENSIRION_WORD_SIZE + CRC8_LEN);
+
+    if (expected_data_length % SENSIRION_WORD_SIZE != 0) {
+        return BYTE_NUM_ERROR;
+    }
+
+    error = sensirion_i2c_write_read(bus, address, tx_data, (uint8_t)tx_length,
+                                     buffer, (uint8_t)size);
+    if (error) {
+        return error;
+    }
+
+    return sensirion_i2c_verify_and_compact(
+        buffer, buffer, expected_data_length / SENSIRION_WORD_SIZE, NULL);
+}
+
+void sensirion_i2c_batch_init(struct sensirion_i2c_batch* batch,
+                              struct sensirion_i2c_hal_transfer* transfers,
+                              uint16_t max_transfers) {
+    batch->transfers = transfers;
+    batch->max_transfers = max_transfers;
+    batch->num_transfers = 0;
+}
+
+int16_t sensirion_i2c_batch_add(struct sensirion_i2c_batch* batch,
+                                uint8_t address, const uint8_t* tx_data,
+                                uint16_t tx_length, uint8_t* buffer,
+                                uint16_t expected_data_length) {
+    struct sensirion_i2c_hal_transfer* transfer;
+
+    if (expected_data_length % SENSIRION_WORD_SIZE != 0) {
+        return BYTE_NUM_ERROR;
+    }
+    /* the HAL transfers at most 255 bytes in each direction */
+    if (tx_length > 0xFF || expected_data_length / SENSIRION_WORD_SIZE >
+                                0xFF / (SENSIRION_WORD_SIZE + CRC8_LEN)) {
+        return BYTE_NUM_ERROR;
+    }
+    if (batch->num_transfers >= batch->max_transfers) {
+        return BATCH_FULL_ERROR;
     }
 
+    transfer = &batch->transfers[batch->num_transfers++];
+    transfer->address = address;
+    transfer->tx_data = tx_data;
+    transfer->tx_count = (uint8_t)tx_length;
+    transfer->rx_data = buffer;
+    transfer->rx_count =
+        (uint8_t)((expected_data_length / SENSIRION_WORD_SIZE) *
+                  (SENSIRION_WORD_SIZE + CRC8_LEN));
+    transfer->error = NO_ERROR;
     return NO_ERROR;
 }
+
+int16_t sensirion_i2c_batch_execute(struct sensirion_i2c_batch* batch,
+                                    int16_t* errors) {
+    return sensirion_i2c_bus_batch_execute(NULL, batch, errors);
+}
+
+int16_t sensirion_i2c_bus_batch_execute(struct sensirion_i2c_hal_bus* bus,
+                                        struct sensirion_i2c_batch* batch,
+                                        int16_t* errors) {
+    struct sensirion_i2c_hal_transfer* transfer;
+    int16_t first_error = NO_ERROR;
+    int16_t error;
+    uint16_t i;
+
+    if (sensirion_i2c_hal_bus_transfer(bus, batch->transfers,
+                                       batch->num_transfers) ==
+        NOT_IMPLEMENTED_ERROR) {
+        for (i = 0; i < batch->num_transfers; ++i) {
+            transfer = &batch->transfers[i];
+            if (transfer->tx_count && transfer->rx_count)
+                transfer->error = sensirion_i2c_write_read(
+                    bus, transfer->address, transfer->tx_data,
+                    transfer->tx_count, transfer->rx_data, transfer->rx_count);
+            else if (transfer->tx_count)
+                transfer->error =
+                    sensirion_i2c_hal_bus_write(bus, transfer->address,
+                                                transfer->tx_data,
+                                                transfer->tx_count);
+            else
+                transfer->error =
+                    sensirion_i2c_hal_bus_read(bus, transfer->address,
+                                               transfer->rx_data,
+                                               transfer->rx_count);
+        }
+    }
+
+    for (i = 0; i < batch->num_transfers; ++i) {
+        transfer = &batch->transfers[i];
+        error = transfer->error;
+        if (error == NO_ERROR) {
+            error = sensirion_i2c_verify_and_compact(
+                transfer->rx_data, transfer->rx_data,
+                transfer->rx_count / (SENSIRION_WORD_SIZE + CRC8_LEN), NULL);
+        }
+        if (errors)
+            errors[i] = error;
+        if (error != NO_ERROR && first_error == NO_ERROR)
+            first_error = error;
+    }
+
+    batch->num_transfers = 0;
+    return first_error;
+}
@@ -33,6 +33,7 @@
 #define SENSIRION_I2C_H
 
 #include "sensirion_config.h"
+#include "sensirion_i2c_hal.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,21 +43,99 @@ extern "C" {
 #define I2C_BUS_ERROR 2
 #define I2C_NACK_ERROR 3
 #define BYTE_NUM_ERROR 4
+#define BATCH_FULL_ERROR 5
 
 #define CRC8_POLYNOMIAL 0x31
 #define CRC8_INIT 0xFF
 #define CRC8_LEN 1
 
+#define SENSIRION_I2C_CRC_ENGINE_BITWISE 0
+#define SENSIRION_I2C_CRC_ENGINE_NIBBLE_TABLE 1
+#define SENSIRION_I2C_CRC_ENGINE_BYTE_TABLE 2
+#define SENSIRION_I2C_CRC_ENGINE_WORD_TABLE 3
+
 #define SENSIRION_COMMAND_SIZE 2
 #define SENSIRION_WORD_SIZE 2
 #define SENSIRION_NUM_WORDS(x) (sizeof(x) / SENSIRION_WORD_SIZE)
 #define SENSIRION_MAX_BUFFER_WORDS 32
 
+/**
+ * List of transfers to many sensors which are executed together by
+ * sensirion_i2c_batch_execute(). Initialize with sensirion_i2c_batch_init().
+ */
+struct sensirion_i2c_batch {
+    struct sensirion_i2c_hal_transfer* transfers;
+    uint16_t max_transfers;
+    uint16_t num_transfers;
+};
+
+/**
+ * sensirion_i2c_crc_init() - prepare the CRC engine
+ *
+ * Fills the 64 KiB table of SENSIRION_I2C_CRC_ENGINE_WORD_TABLE, does nothing
+ * for the other engines. Call it once at startup, before the I2C functions
+ * are used from several threads. Until then the CRCs are calculated with the
+ * byte table.
+ */
+void sensirion_i2c_crc_init(void);
+
+/**
+ * sensirion_i2c_generate_crc() - calculate the CRC-8 of a byte array
+ *
+ * The engine used for the calculation is selected at compile time with
+ * SENSIRION_I2C_CRC_ENGINE in sensirion_config.h.
+ *
+ * @param data  Pointer to the bytes to calculate the checksum of
+ * @param count Number of bytes, usually SENSIRION_WORD_SIZE
+ *
+ * @return      The CRC-8 checksum of the data
+ */
 uint8_t sensirion_i2c_generate_crc(const uint8_t* data, uint16_t count);
 
 int8_t sensirion_i2c_check_crc(const uint8_t* data, uint16_t count,
                                uint8_t checksum);
 
+/**
+ * sensirion_i2c_verify_and_compact() - check the CRC of every received data
+ *                                      word and strip the CRC bytes
+ *
+ * Processes a received frame of [MSB, LSB, CRC] triplets in a single pass, one
+ * word after the other. The data bytes of all words are copied to dst, also
+ * the ones of words with a wrong CRC, use crc_error_mask to find out which
+ * words are affected.
+ *
+ * @param src            Received frame with num_words triplets
+ * @param dst            Buffer to store num_words * SENSIRION_WORD_SIZE data
+ *                       bytes in. May be the same buffer as src.
+ * @param num_words      Number of data words in src
+ * @param crc_error_mask Optional bitmask of (num_words + 7) / 8 bytes. Bit
+ *                       (i % 8) of byte (i / 8) is set if the CRC of word i
+ *                       does not match and cleared otherwise. Can be NULL.
+ *
+ * @return               NO_ERROR if all CRCs match, CRC_ERROR otherwise
+ */
+int16_t sensirion_i2c_verify_and_compact(const uint8_t* src, uint8_t* dst,
+                                         uint16_t num_words,
+                                         uint8_t* crc_error_mask);
+
+/**
+ * sensirion_i2c_expand_with_crc() - expand data words into [MSB, LSB, CRC]
+ *                                   triplets
+ *
+ * Counterpart of sensirion_i2c_verify_and_compact() for building write
+ * frames, one word after the other. The output is identical to adding the
+ * words one by one with sensirion_i2c_add_uint16_t_to_buffer().
+ *
+ * @param src       num_words * SENSIRION_WORD_SIZE data bytes (MSB first)
+ * @param dst       Buffer to store num_words * (SENSIRION_WORD_SIZE +
+ *                  CRC8_LEN) bytes in. Must not overlap with src.
+ * @param num_words Number of data words in src
+ *
+ * @return          Number of bytes written to dst
+ */
+uint16_t sensirion_i2c_expand_with_crc(const uint8_t* src, uint8_t* dst,
+                                       uint16_t num_words);
+
 /**
  * sensirion_i2c_general_call_reset() - Send a general call reset.
  *
@@ -142,6 +221,10 @@ int16_t sensirion_i2c_write_cmd_with_args(uint8_t address, uint16_t command,
 /**
  * sensirion_i2c_delayed_read_cmd() - send a command, wait for the sensor to
  *                                    process and read data back
+ *
+ * Without delay the command and the read are executed as one combined
+ * transaction with sensirion_i2c_hal_write_read().
+ *
  * @address:    Sensor i2c address
  * @cmd:        Command
  * @delay:      Time in microseconds to delay sending the read request
@@ -166,6 +249,57 @@ int16_t sensirion_i2c_delayed_read_cmd(uint8_t address, uint16_t cmd,
 int16_t sensirion_i2c_read_cmd(uint8_t address, uint16_t cmd,
                                uint16_t* data_words, uint16_t num_words);
 
+/**
+ * sensirion_i2c_issue_cmd() - send a command and return when its result can
+ *                             be read, without waiting for it
+ *
+ * First half of sensirion_i2c_delayed_read_cmd(). The processing time of the
+ * sensor can be used to talk to other sensors, sensirion_i2c_fetch_words()
+ * reads the result afterwards.
+ *
+ * @address:     Sensor i2c address
+ * @cmd:         Command
+ * @delay_us:    Time in microseconds the sensor needs to process the command
+ * @ready_at_us: Memory to store the time at which the result is available in,
+ *               as timestamp of sensirion_i2c_hal_get_time_usec(). It includes
+ *               SENSIRION_I2C_HAL_TIME_RESOLUTION_USEC, so the result is not
+ *               read early on clocks with a coarse tick.
+ *
+ * @return       NO_ERROR on success, an error code otherwise
+ */
+int16_t sensirion_i2c_issue_cmd(uint8_t address, uint16_t cmd,
+                                uint32_t delay_us, uint32_t* ready_at_us);
+
+/**
+ * sensirion_i2c_fetch_words() - read the result of a command sent with
+ *                               sensirion_i2c_issue_cmd()
+ *
+ * Sleeps until ready_at_us if that time has not passed yet, then reads and
+ * CRC checks the data words like sensirion_i2c_read_words().
+ *
+ * @address:     Sensor i2c address
+ * @ready_at_us: Timestamp returned by sensirion_i2c_issue_cmd()
+ * @data_words:  Allocated buffer to store the read data
+ * @num_words:   Data words to read (without CRC bytes)
+ *
+ * @return       NO_ERROR on success, an error code otherwise
+ */
+int16_t sensirion_i2c_fetch_words(uint8_t address, uint32_t ready_at_us,
+                                  uint16_t* data_words, uint16_t num_words);
+
+/**
+ * sensirion_i2c_remaining_usec() - time until a timestamp returned by
+ *                                  sensirion_i2c_issue_cmd() is reached
+ *
+ * Handles the wrap around of the timestamps, as long as ready_at_us is less
+ * than 2^31 microseconds away.
+ *
+ * @ready_at_us: Timestamp returned by sensirion_i2c_issue_cmd()
+ *
+ * @return       Remaining microseconds, 0 if the time has already passed
+ */
+uint32_t sensirion_i2c_remaining_usec(uint32_t ready_at_us);
+
 /**
  * sensirion_i2c_add_command_to_buffer() - Add a command to the buffer at
  *                                         offset. Adds 2 bytes to the buffer.
@@ -308,6 +442,157 @@ int16_t sensirion_i2c_write_data(uint8_t address, const uint8_t* data,
  */
 int16_t sensirion_i2c_read_data_inplace(uint8_t address, uint8_t* buffer,
                                         uint16_t expected_data_length);
+
+/**
+ * sensirion_i2c_write_read_data_inplace() - Writes data to the Sensor and
+ *                                           reads its response in one combined
+ *                                           transaction.
+ *
+ * Use this instead of sensirion_i2c_write_data() followed by
+ * sensirion_i2c_read_data_inplace() for commands which do not need any
+ * processing time between the write and the read.
+ *
+ * @param address              Sensor I2C address
+ * @param tx_data              Pointer to the buffer containing the data to
+ *                             write, e.g. prepared with
+ *                             sensirion_i2c_add_command_to_buffer().
+ * @param tx_length            Number of bytes to send to the Sensor.
+ * @param buffer               Allocated buffer to store data as bytes. Needs
+ *                             to be big enough to store the data including
+ *                             CRC. Must not overlap with tx_data.
+ * @param expected_data_length Number of bytes to read (without CRC). Needs
+ *                             to be a multiple of SENSIRION_WORD_SIZE,
+ *                             otherwise the function returns BYTE_NUM_ERROR.
+ *
+ * @return            NO_ERROR on success, an error code otherwise
+ */
+int16_t sensirion_i2c_write_read_data_inplace(uint8_t address,
+                                              const uint8_t* tx_data,
+                                              uint16_t tx_length,
+                                              uint8_t* buffer,
+                                              uint16_t expected_data_length);
+/**
+ * sensirion_i2c_batch_init() - Initialize an empty batch of transfers.
+ *
+ * @param batch         Batch to initialize
+ * @param transfers     Caller provided memory for the transfer descriptors
+ * @param max_transfers Number of descriptors in transfers
+ */
+void sensirion_i2c_batch_init(struct sensirion_i2c_batch* batch,
+                              struct sensirion_i2c_hal_transfer* transfers,
+                              uint16_t max_transfers);
+
+/**
+ * sensirion_i2c_batch_add() - Add a write and/or read to the batch.
+ *
+ * The transfer is executed later by sensirion_i2c_batch_execute(). All
+ * buffers need to stay valid until then.
+ *
+ * @param batch                Batch to add the transfer to
+ * @param address              Sensor I2C address
+ * @param tx_data              Data to write, e.g. a command prepared with
+ *                             sensirion_i2c_add_command_to_buffer(). Can be
+ *                             NULL if tx_length is 0.
+ * @param tx_length            Number of bytes to write, 0 to only read. At
+ *                             most 255.
+ * @param buffer               Buffer to read into, big enough to store the
+ *                             data including CRC like for
+ *                             sensirion_i2c_read_data_inplace(). Can be NULL
+ *                             if expected_data_length is 0.
+ * @param expected_data_length Number of bytes to read (without CRC), 0 to
+ *                             only write. Needs to be a multiple of
+ *                             SENSIRION_WORD_SIZE, at most 170 so that the
+ *                             data including CRC fits in 255 bytes.
+ *
+ * @return NO_ERROR on success, BYTE_NUM_ERROR for a wrong or too long data
+ *         length or BATCH_FULL_ERROR if the batch has no free descriptor left
+ */
+int16_t sensirion_i2c_batch_add(struct sensirion_i2c_batch* batch,
+                                uint8_t address, const uint8_t* tx_data,
+                                uint16_t tx_length, uint8_t* buffer,
+                                uint16_t expected_data_length);
+
+/**
+ * sensirion_i2c_batch_execute() - Execute all transfers of the batch.
+ *
+ * The transfers are passed to sensirion_i2c_hal_transfer() together, the
+ * received data is CRC checked per transfer afterwards and is stored in the
+ * buffer of the transfer like by sensirion_i2c_read_data_inplace(). The batch
+ * is empty again afterwards.
+ *
+ * @param batch  Batch to execute
+ * @param errors Array with one entry per added transfer, in the order they
+ *               were added, to store NO_ERROR or an error code in. Can be NULL.
+ *
+ * @return NO_ERROR if all transfers succeeded, the first error otherwise
+ */
+int16_t sensirion_i2c_batch_execute(struct sensirion_i2c_batch* batch,
+                                    int16_t* errors);
+
+/*
+ * Bus handle variants
+ *
+ * The following functions behave like their counterparts without "bus_" in
+ * the name, but communicate on the given bus instead of the default bus. This
+ * allows to drive several buses in parallel, e.g. one per thread. The bus
+ * handle is initialized with sensirion_i2c_hal_bus_init(), NULL selects the
+ * default bus.
+ */
+
+int16_t
+sensirion_i2c_bus_general_call_reset(struct sensirion_i2c_hal_bus* bus);
+
+int16_t sensirion_i2c_bus_read_words(struct sensirion_i2c_hal_bus* bus,
+                                     uint8_t address, uint16_t* data_words,
+                                     uint16_t num_words);
+
+int16_t sensirion_i2c_bus_read_words_as_bytes(struct sensirion_i2c_hal_bus* bus,
+                                              uint8_t address, uint8_t* data,
+                                              uint16_t num_words);
+
+int16_t sensirion_i2c_bus_write_cmd(struct sensirion_i2c_hal_bus* bus,
+                                    uint8_t address, uint16_t command);
+
+int16_t sensirion_i2c_bus_write_cmd_with_args(struct sensirion_i2c_hal_bus* bus,
+                                              uint8_t address, uint16_t command,
+                                              const uint16_t* data_words,
+                                              uint16_t num_words);
+
+int16_t sensirion_i2c_bus_delayed_read_cmd(struct sensirion_i2c_hal_bus* bus,
+                                           uint8_t address, uint16_t cmd,
+                                           uint32_t delay_us,
+                                           uint16_t* data_words,
+                                           uint16_t num_words);
+
+int16_t sensirion_i2c_bus_read_cmd(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t address, uint16_t cmd,
+                                   uint16_t* data_words, uint16_t num_words);
+
+int16_t sensirion_i2c_bus_issue_cmd(struct sensirion_i2c_hal_bus* bus,
+                                    uint8_t address, uint16_t cmd,
+                                    uint32_t delay_us, uint32_t* ready_at_us);
+
+int16_t sensirion_i2c_bus_fetch_words(struct sensirion_i2c_hal_bus* bus,
+                                      uint8_t address, uint32_t ready_at_us,
+                                      uint16_t* data_words,
+                                      uint16_t num_words);
+
+int16_t sensirion_i2c_bus_write_data(struct sensirion_i2c_hal_bus* bus,
+                                     uint8_t address, const uint8_t* data,
+                                     uint16_t data_length);
+
+int16_t sensirion_i2c_bus_read_data_inplace(struct sensirion_i2c_hal_bus* bus,
+                                            uint8_t address, uint8_t* buffer,
+                                            uint16_t expected_data_length);
+
+int16_t sensirion_i2c_bus_write_read_data_inplace(
+    struct sensirion_i2c_hal_bus* bus, uint8_t address, const uint8_t* tx_data,
+    uint16_t tx_length, uint8_t* buffer, uint16_t expected_data_length);
+
+int16_t sensirion_i2c_bus_batch_execute(struct sensirion_i2c_hal_bus* bus,
+                                        struct sensirion_i2c_batch* batch,
+                                        int16_t* errors);
+
 #ifdef __cplusplus
 }
 #endif
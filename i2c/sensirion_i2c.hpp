@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2026, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SENSIRION_I2C_HPP
+#define SENSIRION_I2C_HPP
+
+/*
+ * Compile time encoding of I2C write frames for C++11 and newer.
+ *
+ * Commands with fixed arguments can be encoded, including the CRC of every
+ * argument word, when the driver is compiled:
+ *
+ *   static constexpr auto start_cmd =
+ *       sensirion::i2c::command_frame<0x0010, 1013>();
+ *   sensirion_i2c_write_data(address, start_cmd.data(), start_cmd.size());
+ *
+ * The resulting std::array has the same content as the buffer filled by
+ * sensirion_i2c_fill_cmd_send_buf().
+ */
+
+#include <array>
+#include <cstddef>
+
+#include "sensirion_config.h"
+#include "sensirion_i2c.h"
+
+namespace sensirion {
+namespace i2c {
+
+namespace detail {
+
+template <std::size_t... I> struct index_sequence {};
+
+template <std::size_t N, std::size_t... I>
+struct make_index_sequence : make_index_sequence<N - 1, N - 1, I...> {};
+
+template <std::size_t... I> struct make_index_sequence<0, I...> {
+    typedef index_sequence<I...> type;
+};
+
+constexpr uint8_t crc_step(uint8_t crc) {
+    return (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ CRC8_POLYNOMIAL)
+                        : static_cast<uint8_t>(crc << 1);
+}
+
+constexpr uint8_t crc_shift(uint8_t crc, unsigned bits) {
+    return bits == 0 ? crc : crc_shift(crc_step(crc), bits - 1);
+}
+
+constexpr uint8_t byte_crc(uint8_t crc, uint8_t data) {
+    return crc_shift(static_cast<uint8_t>(crc ^ data), 8);
+}
+
+constexpr uint8_t word_crc(uint16_t word) {
+    return byte_crc(byte_crc(CRC8_INIT, static_cast<uint8_t>(word >> 8)),
+                    static_cast<uint8_t>(word & 0xFF));
+}
+
+constexpr uint16_t word_at(std::size_t) {
+    return 0;
+}
+
+template <typename... Words>
+constexpr uint16_t word_at(std::size_t index, uint16_t word, Words... words) {
+    return index == 0 ? word : word_at(index - 1, words...);
+}
+
+/* byte at position index of an encoded argument word: MSB, LSB, CRC */
+constexpr uint8_t argument_byte(std::size_t index, uint16_t word) {
+    return index == 0   ? static_cast<uint8_t>(word >> 8)
+           : index == 1 ? static_cast<uint8_t>(word & 0xFF)
+                        : word_crc(word);
+}
+
+/* byte at position index of the frame with the command followed by args */
+template <typename... Words>
+constexpr uint8_t frame_byte(std::size_t index, uint16_t command,
+                             Words... args) {
+    return index < SENSIRION_COMMAND_SIZE
+               ? static_cast<uint8_t>(index == 0 ? command >> 8 : command)
+               : argument_byte((index - SENSIRION_COMMAND_SIZE) %
+                                   (SENSIRION_WORD_SIZE + CRC8_LEN),
+                               word_at((index - SENSIRION_COMMAND_SIZE) /
+                                           (SENSIRION_WORD_SIZE + CRC8_LEN),
+                                       args...));
+}
+
+template <std::size_t... I, typename... Words>
+constexpr std::array<uint8_t, sizeof...(I)>
+encode(index_sequence<I...>, uint16_t command, Words... args) {
+    return std::array<uint8_t, sizeof...(I)>{
+        {frame_byte(I, command, args...)...}};
+}
+
+}  // namespace detail
+
+/**
+ * crc() - CRC-8 of one data word, evaluated at compile time if possible.
+ *
+ * @param word Data word to calculate the checksum of
+ *
+ * @return     The same value as sensirion_i2c_generate_crc() on the MSB first
+ *             representation of word
+ */
+constexpr uint8_t crc(uint16_t word) {
+    return detail::word_crc(word);
+}
+
+/**
+ * command_frame() - Encode a command and its argument words.
+ *
+ * @tparam Command The I2C command
+ * @tparam Args    Argument words, the CRC is inserted after every word
+ *
+ * @return         The encoded frame, ready to be passed to
+ *                 sensirion_i2c_write_data() or sensirion_i2c_hal_write()
+ */
+template <uint16_t Command, uint16_t... Args>
+constexpr std::array<uint8_t, SENSIRION_COMMAND_SIZE +
+                                  sizeof...(Args) *
+                                      (SENSIRION_WORD_SIZE + CRC8_LEN)>
+command_frame() {
+    return detail::encode(
+        typename detail::make_index_sequence<
+            SENSIRION_COMMAND_SIZE +
+            sizeof...(Args) * (SENSIRION_WORD_SIZE + CRC8_LEN)>::type(),
+        Command, Args...);
+}
+
+}  // namespace i2c
+}  // namespace sensirion
+
+#endif /* SENSIRION_I2C_HPP */
@@ -105,6 +105,162 @@ int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
     return NOT_IMPLEMENTED_ERROR;
 }
 
+/**
+ * Execute a write transaction followed by a read transaction on the I2C bus
+ * without releasing the bus in between (repeated start), e.g. to send a
+ * command and read its response. If the device does not acknowledge any of
+ * the bytes, an error shall be returned.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR to let the
+ * caller use sensirion_i2c_hal_write() followed by sensirion_i2c_hal_read(),
+ * e.g. on platforms without support for repeated starts.
+ *
+ * @param address  7-bit I2C address to write to and read from
+ * @param tx_data  pointer to the buffer containing the data to write
+ * @param tx_count number of bytes to send over I2C
+ * @param rx_data  pointer to the buffer where the read data is to be stored
+ * @param rx_count number of bytes to read from I2C and store in the buffer
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_write_read(uint8_t address, const uint8_t* tx_data,
+                                    uint8_t tx_count, uint8_t* rx_data,
+                                    uint8_t rx_count) {
+    /* TODO:IMPLEMENT or leave as is to use write followed by read */
+    return NOT_IMPLEMENTED_ERROR;
+}
+
+/**
+ * Execute a list of transfers, possibly to different addresses, with as
+ * little overhead between them as the platform allows. The error member of
+ * every transfer must be set to 0 on success and to an error code otherwise.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR without touching
+ * the transfers to let the caller execute them one by one.
+ *
+ * @param transfers list of transfers to execute
+ * @param count     number of transfers in the list
+ * @returns 0 if all transfers succeeded, error code otherwise
+ */
+int8_t sensirion_i2c_hal_transfer(struct sensirion_i2c_hal_transfer* transfers,
+                                  uint16_t count) {
+    /* TODO:IMPLEMENT or leave as is to execute the transfers one by one */
+    return NOT_IMPLEMENTED_ERROR;
+}
+
+/**
+ * Initialize a bus handle for the bus with the given index and all hard- and
+ * software components that are needed to communicate on it.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL ON SINGLE-BUS SETUPS: the bus functions may
+ * ignore the bus index and the bus handle and use the default bus.
+ *
+ * @param bus     bus handle to initialize
+ * @param bus_idx platform specific index of the bus
+ * @returns 0 on success, error code otherwise
+ */
+int16_t sensirion_i2c_hal_bus_init(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t bus_idx) {
+    /* TODO:IMPLEMENT or leave as is if all sensors are located on one single
+     * bus */
+    bus->bus_idx = bus_idx;
+    bus->handle = 0;
+    bus->address = 0;
+    return NO_ERROR;
+}
+
+/**
+ * Release all resources initialized by sensirion_i2c_hal_bus_init().
+ *
+ * @param bus bus handle to release
+ */
+void sensirion_i2c_hal_bus_free(struct sensirion_i2c_hal_bus* bus) {
+    /* TODO:IMPLEMENT or leave empty if no resources need to be freed */
+}
+
+/**
+ * Same as sensirion_i2c_hal_read() on the given bus.
+ *
+ * @param bus     bus handle or NULL for the default bus
+ * @param address 7-bit I2C address to read from
+ * @param data    pointer to the buffer where the data is to be stored
+ * @param count   number of bytes to read from I2C and store in the buffer
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_bus_read(struct sensirion_i2c_hal_bus* bus,
+                                  uint8_t address, uint8_t* data,
+                                  uint8_t count) {
+    /* TODO:IMPLEMENT or leave as is on single-bus setups */
+    return sensirion_i2c_hal_read(address, data, count);
+}
+
+/**
+ * Same as sensirion_i2c_hal_write() on the given bus.
+ *
+ * @param bus     bus handle or NULL for the default bus
+ * @param address 7-bit I2C address to write to
+ * @param data    pointer to the buffer containing the data to write
+ * @param count   number of bytes to read from the buffer and send over I2C
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_bus_write(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t address, const uint8_t* data,
+                                   uint8_t count) {
+    /* TODO:IMPLEMENT or leave as is on single-bus setups */
+    return sensirion_i2c_hal_write(address, data, count);
+}
+
+/**
+ * Same as sensirion_i2c_hal_write_read() on the given bus.
+ *
+ * @param bus      bus handle or NULL for the default bus
+ * @param address  7-bit I2C address to write to and read from
+ * @param tx_data  pointer to the buffer containing the data to write
+ * @param tx_count number of bytes to send over I2C
+ * @param rx_data  pointer to the buffer where the read data is to be stored
+ * @param rx_count number of bytes to read from I2C and store in the buffer
+ * @returns 0 on success, error code otherwise
+ */
+int8_t sensirion_i2c_hal_bus_write_read(struct sensirion_i2c_hal_bus* bus,
+                                        uint8_t address, const uint8_t* tx_data,
+                                        uint8_t tx_count, uint8_t* rx_data,
+                                        uint8_t rx_count) {
+    /* TODO:IMPLEMENT or leave as is on single-bus setups */
+    return sensirion_i2c_hal_write_read(address, tx_data, tx_count, rx_data,
+                                        rx_count);
+}
+
+/**
+ * Same as sensirion_i2c_hal_transfer() on the given bus.
+ *
+ * @param bus       bus handle or NULL for the default bus
+ * @param transfers list of transfers to execute
+ * @param count     number of transfers in the list
+ * @returns 0 if all transfers succeeded, error code otherwise
+ */
+int8_t
+sensirion_i2c_hal_bus_transfer(struct sensirion_i2c_hal_bus* bus,
+                               struct sensirion_i2c_hal_transfer* transfers,
+                               uint16_t count) {
+    /* TODO:IMPLEMENT or leave as is on single-bus setups */
+    return sensirion_i2c_hal_transfer(transfers, count);
+}
+
+/**
+ * Return a monotonic timestamp in microseconds, e.g. the time since boot. The
+ * timestamp may wrap around, only differences between timestamps are used.
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. A platform without time source returns 0,
+ * then sensirion_i2c_fetch_words() always sleeps for the whole command delay.
+ * Set SENSIRION_I2C_HAL_TIME_RESOLUTION_USEC in sensirion_config.h to the
+ * resolution of the timestamps.
+ *
+ * @returns the current time in microseconds
+ */
+uint32_t sensirion_i2c_hal_get_time_usec(void) {
+    /* TODO:IMPLEMENT or leave as is if no time source is available */
+    return 0;
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution for at least the given time, but may also sleep longer.
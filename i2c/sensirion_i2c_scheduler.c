@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2026, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sensirion_i2c_scheduler.h"
+#include "sensirion_common.h"
+#include "sensirion_config.h"
+#include "sensirion_i2c.h"
+#include "sensirion_i2c_hal.h"
+
+/* halve the utilization window when it gets longer than about 18 minutes */
+#define SCHEDULER_MAX_WINDOW_US 0x40000000UL
+
+/* wrap around safe a < b for timestamps */
+static int sensirion_i2c_scheduler_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+static void sensirion_i2c_scheduler_swap(
+    struct sensirion_i2c_scheduler_device** heap, uint16_t i, uint16_t j) {
+    struct sensirion_i2c_scheduler_device* tmp = heap[i];
+    heap[i] = heap[j];
+    heap[j] = tmp;
+}
+
+static void sensirion_i2c_scheduler_sift_up(
+    struct sensirion_i2c_scheduler* scheduler, uint16_t i) {
+    struct sensirion_i2c_scheduler_device** heap = scheduler->heap;
+    uint16_t parent;
+
+    while (i > 0) {
+        parent = (uint16_t)((i - 1) / 2);
+        if (!sensirion_i2c_scheduler_before(heap[i]->deadline_us,
+                                            heap[parent]->deadline_us))
+            break;
+        sensirion_i2c_scheduler_swap(heap, i, parent);
+        i = parent;
+    }
+}
+
+static void sensirion_i2c_scheduler_sift_down(
+    struct sensirion_i2c_scheduler* scheduler, uint16_t i) {
+    struct sensirion_i2c_scheduler_device** heap = scheduler->heap;
+    uint16_t child;
+    uint16_t smallest;
+
+    for (;;) {
+        smallest = i;
+        child = (uint16_t)(2 * i + 1);
+        if (child < scheduler->num_devices &&
+            sensirion_i2c_scheduler_before(heap[child]->deadline_us,
+                                           heap[smallest]->deadline_us))
+            smallest = child;
+        ++child;
+        if (child < scheduler->num_devices &&
+            sensirion_i2c_scheduler_before(heap[child]->deadline_us,
+                                           heap[smallest]->deadline_us))
+            smallest = child;
+        if (smallest == i)
+            return;
+        sensirion_i2c_scheduler_swap(heap, i, smallest);
+        i = smallest;
+    }
+}
+
+/* plan the next measurement of the device at the root of the heap */
+static void sensirion_i2c_scheduler_reschedule(
+    struct sensirion_i2c_scheduler* scheduler,
+    struct sensirion_i2c_scheduler_device* device, uint32_t now) {
+
+    device->measuring = 0;
+    device->next_start_us += device->period_us;
+    /* skip measurements which can not be caught up with anymore */
+    if (sensirion_i2c_scheduler_before(
+            device->next_start_us + device->period_us, now))
+        device->next_start_us = now;
+    device->deadline_us = device->next_start_us;
+    sensirion_i2c_scheduler_sift_down(scheduler, 0);
+}
+
+static void sensirion_i2c_scheduler_update_period(
+    struct sensirion_i2c_scheduler_device* device, uint32_t start) {
+    uint32_t period;
+    uint32_t deviation;
+
+    if (device->num_samples + device->num_errors > 0) {
+        period = start - device->last_start_us;
+        deviation = period > device->period_us ? period - device->period_us
+                                               : device->period_us - period;
+        if (device->achieved_period_us == 0) {
+            device->achieved_period_us = period;
+        } else {
+            /* moving averages with gain 1/8 and 1/16, the latter like the
+             * interarrival jitter of RFC 3550 */
+            device->achieved_period_us =
+                device->achieved_period_us - device->achieved_period_us / 8 +
+                period / 8;
+        }
+        device->jitter_us = device->jitter_us - device->jitter_us / 16 +
+                            deviation / 16;
+    }
+    device->last_start_us = start;
+}
+
+void sensirion_i2c_scheduler_init(
+    struct sensirion_i2c_scheduler* scheduler,
+    struct sensirion_i2c_scheduler_device** heap, uint16_t max_devices) {
+    scheduler->heap = heap;
+    scheduler->max_devices = max_devices;
+    scheduler->num_devices = 0;
+    scheduler->busy_us = 0;
+    scheduler->window_start_us = sensirion_i2c_hal_get_time_usec();
+}
+
+void sensirion_i2c_scheduler_device_init(
+    struct sensirion_i2c_scheduler_device* device,
+    struct sensirion_i2c_hal_bus* bus, uint8_t address, uint16_t command,
+    uint32_t delay_us, uint32_t period_us, uint16_t* data_words,
+    uint16_t num_words) {
+    device->bus = bus;
+    device->address = address;
+    device->command = command;
+    device->delay_us = delay_us;
+    device->period_us = period_us;
+    device->data_words = data_words;
+    device->num_words = num_words;
+
+    device->deadline_us = 0;
+    device->next_start_us = 0;
+    device->last_start_us = 0;
+    device->measuring = 0;
+
+    device->num_samples = 0;
+    device->num_errors = 0;
+    device->achieved_period_us = 0;
+    device->jitter_us = 0;
+}
+
+int16_t
+sensirion_i2c_scheduler_add(struct sensirion_i2c_scheduler* scheduler,
+                            struct sensirion_i2c_scheduler_device* device) {
+    if (scheduler->num_devices >= scheduler->max_devices) {
+        return SCHEDULER_FULL_ERROR;
+    }
+
+    device->next_start_us = sensirion_i2c_hal_get_time_usec();
+    device->deadline_us = device->next_start_us;
+    device->measuring = 0;
+    scheduler->heap[scheduler->num_devices] = device;
+    sensirion_i2c_scheduler_sift_up(scheduler, scheduler->num_devices++);
+    return NO_ERROR;
+}
+
+int16_t sensirion_i2c_scheduler_poll(
+    struct sensirion_i2c_scheduler* scheduler,
+    struct sensirion_i2c_scheduler_device** device) {
+    struct sensirion_i2c_scheduler_device* next;
+    uint32_t remaining;
+    uint32_t start;
+    uint32_t end;
+    uint32_t elapsed;
+    int16_t error;
+
+    *device = NULL;
+    while (scheduler->num_devices > 0) {
+        next = scheduler->heap[0];
+        remaining = sensirion_i2c_remaining_usec(next->deadline_us);
+        if (remaining)
+            sensirion_i2c_hal_sleep_usec(remaining);
+
+        start = sensirion_i2c_hal_get_time_usec();
+        if (next->measuring) {
+            error = sensirion_i2c_bus_read_words(
+                next->bus, next->address, next->data_words, next->num_words);
+        } else {
+            sensirion_i2c_scheduler_update_period(next, start);
+            error = sensirion_i2c_bus_write_cmd(next->bus, next->address,
+                                                next->command);
+        }
+        end = sensirion_i2c_hal_get_time_usec();
+
+        scheduler->busy_us += end - start;
+        elapsed = end - scheduler->window_start_us;
+        if (elapsed > SCHEDULER_MAX_WINDOW_US) {
+            scheduler->busy_us /= 2;
+            scheduler->window_start_us += elapsed / 2;
+        }
+
+        if (error != NO_ERROR) {
+            ++next->num_errors;
+            sensirion_i2c_scheduler_reschedule(scheduler, next, end);
+            *device = next;
+            return error;
+        }
+
+        if (!next->measuring) {
+            /* let the others use the bus while the sensor measures, the
+             * clock may tick right after the command was sent */
+            next->measuring = 1;
+            next->deadline_us = end + next->delay_us +
+                                SENSIRION_I2C_HAL_TIME_RESOLUTION_USEC;
+            sensirion_i2c_scheduler_sift_down(scheduler, 0);
+            continue;
+        }
+
+        ++next->num_samples;
+        sensirion_i2c_scheduler_reschedule(scheduler, next, end);
+        *device = next;
+        return NO_ERROR;
+    }
+    return NO_ERROR;
+}
+
+uint16_t sensirion_i2c_scheduler_bus_utilization(
+    const struct sensirion_i2c_scheduler* scheduler) {
+    uint32_t elapsed_ms =
+        (sensirion_i2c_hal_get_time_usec() - scheduler->window_start_us) / 1000;
+
+    if (elapsed_ms == 0)
+        return 0;
+    if (scheduler->busy_us / elapsed_ms > 1000)
+        return 1000;
+    return (uint16_t)(scheduler->busy_us / elapsed_ms);
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2026, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SENSIRION_I2C_SCHEDULER_H
+#define SENSIRION_I2C_SCHEDULER_H
+
+#include "sensirion_config.h"
+#include "sensirion_i2c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCHEDULER_FULL_ERROR 6
+
+/**
+ * Periodic measurement of one sensor driven by the scheduler. Initialize with
+ * sensirion_i2c_scheduler_device_init(), the members below the configuration
+ * are managed by the scheduler.
+ */
+struct sensirion_i2c_scheduler_device {
+    /* configuration */
+    struct sensirion_i2c_hal_bus* bus;
+    uint8_t address;
+    uint16_t command;
+    uint32_t delay_us;
+    uint32_t period_us;
+    uint16_t* data_words;
+    uint16_t num_words;
+
+    /* state */
+    uint32_t deadline_us;   /* time of the next action, key of the heap */
+    uint32_t next_start_us; /* planned start of the next measurement */
+    uint32_t last_start_us; /* actual start of the last measurement */
+    uint8_t measuring;      /* command sent, waiting for the result */
+
+    /* statistics */
+    uint32_t num_samples;
+    uint32_t num_errors;
+    uint32_t achieved_period_us; /* average time between measurement starts */
+    uint32_t jitter_us; /* average deviation of that time from period_us */
+};
+
+/**
+ * Deadline ordered set of devices. Initialize with
+ * sensirion_i2c_scheduler_init().
+ */
+struct sensirion_i2c_scheduler {
+    struct sensirion_i2c_scheduler_device** heap;
+    uint16_t max_devices;
+    uint16_t num_devices;
+    uint32_t busy_us;         /* time spent in bus transactions ... */
+    uint32_t window_start_us; /* ... since this timestamp */
+};
+
+/**
+ * sensirion_i2c_scheduler_init() - Initialize an empty scheduler.
+ *
+ * @param scheduler   Scheduler to initialize
+ * @param heap        Caller provided memory for max_devices device pointers
+ * @param max_devices Number of entries in heap
+ */
+void sensirion_i2c_scheduler_init(
+    struct sensirion_i2c_scheduler* scheduler,
+    struct sensirion_i2c_scheduler_device** heap, uint16_t max_devices);
+
+/**
+ * sensirion_i2c_scheduler_device_init() - Describe the periodic measurement of
+ *                                         a sensor.
+ *
+ * Every period_us the command is sent, after delay_us num_words data words
+ * are read into data_words like with sensirion_i2c_delayed_read_cmd().
+ *
+ * @param device     Device to initialize
+ * @param bus        Bus handle or NULL for the default bus
+ * @param address    Sensor I2C address
+ * @param command    Command which starts a measurement
+ * @param delay_us   Time in microseconds the sensor needs for the measurement
+ * @param period_us  Time in microseconds between two measurement starts
+ * @param data_words Allocated buffer to store the read data
+ * @param num_words  Data words to read (without CRC bytes)
+ */
+void sensirion_i2c_scheduler_device_init(
+    struct sensirion_i2c_scheduler_device* device,
+    struct sensirion_i2c_hal_bus* bus, uint8_t address, uint16_t command,
+    uint32_t delay_us, uint32_t period_us, uint16_t* data_words,
+    uint16_t num_words);
+
+/**
+ * sensirion_i2c_scheduler_add() - Add a device to the scheduler.
+ *
+ * The first measurement of the device is started immediately. The device
+ * needs to stay valid as long as the scheduler is used.
+ *
+ * @param scheduler Scheduler to add the device to
+ * @param device    Device initialized with
+ *                  sensirion_i2c_scheduler_device_init()
+ *
+ * @return NO_ERROR on success, SCHEDULER_FULL_ERROR if the heap is full
+ */
+int16_t
+sensirion_i2c_scheduler_add(struct sensirion_i2c_scheduler* scheduler,
+                            struct sensirion_i2c_scheduler_device* device);
+
+/**
+ * sensirion_i2c_scheduler_poll() - Run the scheduler until the next sample is
+ *                                  available.
+ *
+ * Sends the commands and reads the results of all devices in the order of
+ * their deadlines and sleeps in between. While one sensor measures, the
+ * others are served. Returns as soon as one measurement is finished, or
+ * failed.
+ *
+ * The scheduler needs a time source, see sensirion_i2c_hal_get_time_usec().
+ * Results are read SENSIRION_I2C_HAL_TIME_RESOLUTION_USEC after the delay_us
+ * of the device, so they are not read early on clocks with a coarse tick.
+ *
+ * @param scheduler Scheduler to run
+ * @param device    Memory to store the device in whose data_words were just
+ *                  updated or whose command or read failed. NULL if the
+ *                  scheduler is empty.
+ *
+ * @return NO_ERROR on success, the error of the failed command or read
+ *         otherwise
+ */
+int16_t sensirion_i2c_scheduler_poll(
+    struct sensirion_i2c_scheduler* scheduler,
+    struct sensirion_i2c_scheduler_device** device);
+
+/**
+ * sensirion_i2c_scheduler_bus_utilization() - Share of the time the scheduler
+ *                                             spent in bus transactions.
+ *
+ * The share is averaged over the last 9 to 18 minutes of operation.
+ *
+ * @param scheduler Scheduler to query
+ *
+ * @return Bus utilization in per mille
+ */
+uint16_t sensirion_i2c_scheduler_bus_utilization(
+    const struct sensirion_i2c_scheduler* scheduler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSIRION_I2C_SCHEDULER_H */
@@ -35,9 +35,13 @@
 #include "sensirion_uart_hal.h"
 #include "sensirion_common.h"
 #include "sensirion_config.h"
+#include <asm/termbits.h> /* termios2 for arbitrary baudrates */
 #include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
-#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
 /* Adapted from
@@ -48,9 +52,40 @@
 #define SENSIRION_UART_TTYDEV "/dev/ttyUSB0"
 #endif
 
-static int uart_fd = -1;
+/* baudrate after sensirion_uart_hal_port_init(), any rate the UART supports
+ * can be set with sensirion_uart_hal_port_set_baudrate() */
+#ifndef SENSIRION_UART_BAUDRATE
+#define SENSIRION_UART_BAUDRATE 115200
+#endif
+
+static struct sensirion_uart_hal_port default_port = {SENSIRION_UART_TTYDEV,
+                                                      -1};
+
+static struct sensirion_uart_hal_port*
+sensirion_uart_hal_get_port(struct sensirion_uart_hal_port* port) {
+    return port ? port : &default_port;
+}
 
 int16_t sensirion_uart_hal_init() {
+    return sensirion_uart_hal_port_init(&default_port, SENSIRION_UART_TTYDEV);
+}
+
+int16_t sensirion_uart_hal_free() {
+    return sensirion_uart_hal_port_free(&default_port);
+}
+
+int16_t sensirion_uart_hal_tx(uint16_t data_len, const uint8_t* data) {
+    return sensirion_uart_hal_port_tx(NULL, data_len, data);
+}
+
+int16_t sensirion_uart_hal_rx(uint16_t max_data_len, uint8_t* data) {
+    return sensirion_uart_hal_port_rx(NULL, max_data_len, data);
+}
+
+int16_t sensirion_uart_hal_port_init(struct sensirion_uart_hal_port* port,
+                                     const char* device) {
+    struct termios2 options;
+
     /*
      * The flags (defined in fcntl.h):
      * Access modes (use 1 of these):
@@ -66,14 +101,16 @@ int16_t sensirion_uart_hal_init() {
      *      shall not cause the terminal device to become the controlling
      *      terminal for the process.
      */
-    uart_fd = open(SENSIRION_UART_TTYDEV, O_RDWR | O_NOCTTY);
-    if (uart_fd == -1) {
+    port->device = device;
+    port->handle = open(device, O_RDWR | O_NOCTTY);
+    if (port->handle == -1) {
         fprintf(stderr, "Error opening UART. Ensure it's not otherwise used\n");
         return -1;
     }
 
     /*
      * see http://pubs.opengroup.org/onlinepubs/007908799/xsh/termios.h.html:
+     *    BOTHER - Baudrate given in c_ospeed instead of a Bxxx constant
      *    CSIZE:- CS5, CS6, CS7, CS8
      *    CLOCAL - Ignore modem status lines
      *    CREAD - Enable receiver
@@ -84,34 +121,122 @@ int16_t sensirion_uart_hal_init() {
      *    PARENB - Parity enable
      *    PARODD - Odd parity (else even)
      */
-    struct termios options;
-    tcgetattr(uart_fd, &options);
-    options.c_cflag = B115200 | CS8 | CLOCAL | CREAD; /* set baud rate */
+    ioctl(port->handle, TCGETS2, &options);
+    options.c_cflag = BOTHER | CS8 | CLOCAL | CREAD; /* set baud rate */
+    options.c_ispeed = SENSIRION_UART_BAUDRATE;
+    options.c_ospeed = SENSIRION_UART_BAUDRATE;
     options.c_iflag = IGNPAR;
     options.c_oflag = 0;
     options.c_lflag = 0;
-    tcflush(uart_fd, TCIFLUSH);
-    tcsetattr(uart_fd, TCSANOW, &options);
+    ioctl(port->handle, TCFLSH, TCIFLUSH);
+    ioctl(port->handle, TCSETS2, &options);
     return 0;
 }
 
-int16_t sensirion_uart_hal_free() {
-    return close(uart_fd);
+int16_t
+sensirion_uart_hal_port_set_baudrate(struct sensirion_uart_hal_port* port,
+                                     uint32_t baudrate) {
+    struct termios2 options;
+
+    port = sensirion_uart_hal_get_port(port);
+    if (port->handle == -1 || ioctl(port->handle, TCGETS2, &options) == -1)
+        return -1;
+
+    options.c_cflag &= ~(tcflag_t)(CBAUD | (CBAUD << IBSHIFT));
+    options.c_cflag |= BOTHER;
+    options.c_ispeed = baudrate;
+    options.c_ospeed = baudrate;
+    /* let pending output go out with the old baudrate first */
+    if (ioctl(port->handle, TCSETSW2, &options) == -1)
+        return -1;
+    return 0;
 }
 
-int16_t sensirion_uart_hal_tx(uint16_t data_len, const uint8_t* data) {
-    if (uart_fd == -1)
+int16_t sensirion_uart_hal_port_free(struct sensirion_uart_hal_port* port) {
+    int16_t ret = close(port->handle);
+
+    port->handle = -1;
+    return ret;
+}
+
+int16_t sensirion_uart_hal_port_tx(struct sensirion_uart_hal_port* port,
+                                   uint16_t data_len, const uint8_t* data) {
+    port = sensirion_uart_hal_get_port(port);
+    if (port->handle == -1)
         return -1;
 
-    return write(uart_fd, (void*)data, data_len);
+    return write(port->handle, (void*)data, data_len);
 }
 
-int16_t sensirion_uart_hal_rx(uint16_t max_data_len, uint8_t* data) {
-    if (uart_fd == -1)
+int16_t sensirion_uart_hal_port_rx(struct sensirion_uart_hal_port* port,
+                                   uint16_t max_data_len, uint8_t* data) {
+    port = sensirion_uart_hal_get_port(port);
+    if (port->handle == -1)
         return -1;
 
-    return read(uart_fd, (void*)data, max_data_len);
+    return read(port->handle, (void*)data, max_data_len);
 }
+
+int16_t sensirion_uart_hal_port_tx_vec(
+    struct sensirion_uart_hal_port* port,
+    const struct sensirion_uart_hal_segment* segments, uint16_t num_segments) {
+    struct iovec iov[SENSIRION_UART_HAL_MAX_SEGMENTS];
+    struct iovec* next = iov;
+    ssize_t written;
+    uint16_t i;
+
+    port = sensirion_uart_hal_get_port(port);
+    if (port->handle == -1 || num_segments > SENSIRION_UART_HAL_MAX_SEGMENTS)
+        return -1;
+
+    for (i = 0; i < num_segments; ++i) {
+        iov[i].iov_base = (void*)segments[i].data;
+        iov[i].iov_len = segments[i].length;
+    }
+
+    /* the tty may take only a part, continue where it stopped */
+    while (num_segments) {
+        written = writev(port->handle, next, num_segments);
+        if (written < 0)
+            return -1;
+        while (num_segments && (size_t)written >= next->iov_len) {
+            written -= (ssize_t)next->iov_len;
+            ++next;
+            --num_segments;
+        }
+        if (num_segments) {
+            next->iov_base = (uint8_t*)next->iov_base + written;
+            next->iov_len -= (size_t)written;
+        }
+    }
+    return 0;
+}
+
+int16_t sensirion_uart_hal_port_wait_rx(struct sensirion_uart_hal_port* port,
+                                        uint32_t timeout_us) {
+    struct pollfd fds;
+    int ret;
+
+    port = sensirion_uart_hal_get_port(port);
+    if (port->handle == -1)
+        return -1;
+
+    fds.fd = port->handle;
+    fds.events = POLLIN;
+    /* round up to not return before the timeout has passed */
+    ret = poll(&fds, 1, (int)((timeout_us + 999) / 1000));
+    if (ret < 0)
+        return -1;
+    return ret > 0 ? 1 : 0;
+}
+
+uint32_t sensirion_uart_hal_get_time_usec(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec * 1000000 + (uint32_t)now.tv_nsec / 1000;
+}
+
 void sensirion_uart_hal_sleep_usec(uint32_t useconds) {
     usleep(useconds);
 }
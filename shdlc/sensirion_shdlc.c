@@ -37,23 +37,71 @@
 #define SHDLC_START 0x7e
 #define SHDLC_STOP 0x7e
 
+#if SENSIRION_SHDLC_MAX_DATA_LENGTH > 255
+#error "SENSIRION_SHDLC_MAX_DATA_LENGTH must not exceed 255"
+#endif
+
 #define SHDLC_MIN_TX_FRAME_SIZE 6
-/** start/stop + (4 header + 255 data) * 2 because of byte stuffing */
-#define SHDLC_FRAME_MAX_TX_FRAME_SIZE (2 + (4 + 255) * 2)
+/** start/stop + (4 header + data) * 2 because of byte stuffing */
+#define SHDLC_FRAME_MAX_TX_FRAME_SIZE \
+    (2 + (4 + SENSIRION_SHDLC_MAX_DATA_LENGTH) * 2)
 
-/** start/stop + (5 header + 255 data) * 2 because of byte stuffing */
-#define SHDLC_FRAME_MAX_RX_FRAME_SIZE (2 + (5 + 255) * 2)
+/* state of the default port, the HAL keeps its UART handle private */
+static struct sensirion_shdlc_port default_port;
 
-#define RX_DELAY_US 20000
+/* UART handle of the port for the HAL, NULL for the default port */
+static struct sensirion_uart_hal_port*
+sensirion_shdlc_uart(struct sensirion_shdlc_port* port) {
+    return port ? &port->uart : NULL;
+}
 
-static uint8_t sensirion_shdlc_checksum(uint8_t header_sum, uint8_t data_len,
-                                        const uint8_t* data) {
-    header_sum += data_len;
+static struct sensirion_shdlc_command_timings*
+sensirion_shdlc_command_timings(struct sensirion_shdlc_port* port) {
+    return port ? &port->command_timings : &default_port.command_timings;
+}
 
-    while (data_len--)
-        header_sum += *(data++);
+/* timing of a command on the port, NULL if it is not known */
+static struct sensirion_shdlc_command_timing*
+sensirion_shdlc_find_command_timing(struct sensirion_shdlc_port* port,
+                                    uint8_t addr, uint8_t cmd) {
+    struct sensirion_shdlc_command_timings* timings =
+        sensirion_shdlc_command_timings(port);
+    uint16_t i;
 
-    return ~header_sum;
+    for (i = 0; i < timings->count; ++i) {
+        if (timings->entries[i].addr == addr && timings->entries[i].cmd == cmd)
+            return &timings->entries[i];
+    }
+    return NULL;
+}
+
+/* add a command with the default timing. An explicitly set timing replaces a
+ * measured one if the table is full. NULL if there is no space. */
+static struct sensirion_shdlc_command_timing*
+sensirion_shdlc_add_command_timing(struct sensirion_shdlc_port* port,
+                                   uint8_t addr, uint8_t cmd, bool is_set) {
+    struct sensirion_shdlc_command_timings* timings =
+        sensirion_shdlc_command_timings(port);
+    struct sensirion_shdlc_command_timing* timing = NULL;
+    uint16_t i;
+
+    if (timings->count < SENSIRION_SHDLC_MAX_COMMAND_TIMINGS) {
+        timing = &timings->entries[timings->count++];
+    } else if (is_set) {
+        for (i = 0; i < timings->count && !timing; ++i) {
+            if (!timings->entries[i].is_set)
+                timing = &timings->entries[i];
+        }
+    }
+    if (!timing)
+        return NULL;
+
+    timing->addr = addr;
+    timing->cmd = cmd;
+    timing->is_set = is_set;
+    timing->expected_latency_us = SENSIRION_SHDLC_DEFAULT_LATENCY_US;
+    timing->timeout_us = SENSIRION_SHDLC_DEFAULT_TIMEOUT_US;
+    return timing;
 }
 
 static uint16_t sensirion_shdlc_stuff_data(uint8_t data_len,
@@ -82,57 +130,490 @@ static uint16_t sensirion_shdlc_stuff_data(uint8_t data_len,
     return output_data_len;
 }
 
-static uint8_t sensirion_shdlc_check_unstuff(uint8_t data) {
-    return data == 0x7d;
+/* nonzero if any byte of the word is zero */
+#define SHDLC_HAS_ZERO_BYTE(w) \
+    (((w) - (uint32_t)0x01010101) & ~(w) & (uint32_t)0x80808080)
+
+/* nonzero if any byte of the word is 0x11, 0x13, 0x7d or 0x7e. 0x11 and 0x13
+ * only differ in bit 1 which is masked. */
+#define SHDLC_NEEDS_STUFFING(w)                                       \
+    (SHDLC_HAS_ZERO_BYTE(((w) & (uint32_t)0xFDFDFDFD) ^ 0x11111111) || \
+     SHDLC_HAS_ZERO_BYTE((w) ^ (uint32_t)0x7D7D7D7D) ||                \
+     SHDLC_HAS_ZERO_BYTE((w) ^ (uint32_t)0x7E7E7E7E))
+
+/* bytes to stuff followed by their stuffed form */
+static const uint8_t shdlc_stuffed_bytes[4][3] = {
+    {0x11, 0x7d, 0x31},
+    {0x13, 0x7d, 0x33},
+    {0x7d, 0x7d, 0x5d},
+    {0x7e, 0x7d, 0x5e},
+};
+
+/* number of bytes at the start of data which don't need stuffing, they are
+ * added to the checksum. The data is checked four bytes at a time. */
+static uint16_t sensirion_shdlc_unstuffed_run(const uint8_t* data,
+                                              uint16_t data_len,
+                                              uint8_t* checksum) {
+    uint16_t i = 0;
+    uint32_t word;
+    uint32_t sum;
+    uint8_t c;
+
+    for (; i + 4 <= data_len; i += 4) {
+        word = (uint32_t)data[i] | (uint32_t)data[i + 1] << 8 |
+               (uint32_t)data[i + 2] << 16 | (uint32_t)data[i + 3] << 24;
+        if (SHDLC_NEEDS_STUFFING(word))
+            break;
+        /* add the bytes pairwise in 16 bit lanes, then fold the lanes */
+        sum = (word & 0x00FF00FF) + ((word >> 8) & 0x00FF00FF);
+        *checksum += (uint8_t)(sum + (sum >> 16));
+    }
+    for (; i < data_len; ++i) {
+        c = data[i];
+        if (c == 0x11 || c == 0x13 || c == 0x7d || c == 0x7e)
+            break;
+        *checksum += c;
+    }
+    return i;
 }
 
-static uint8_t sensirion_shdlc_unstuff_byte(uint8_t data) {
-    switch (data) {
-        case 0x31:
-            return 0x11;
-        case 0x33:
-            return 0x13;
-        case 0x5d:
-            return 0x7d;
-        case 0x5e:
-            return 0x7e;
+/* stuff data and add it to the checksum in one pass */
+static uint16_t sensirion_shdlc_stuff_bytes(const uint8_t* data,
+                                            uint16_t data_len,
+                                            uint8_t* stuffed_data,
+                                            uint8_t* checksum) {
+    uint16_t len = 0;
+    uint16_t run;
+
+    while (data_len) {
+        run = sensirion_shdlc_unstuffed_run(data, data_len, checksum);
+        data_len -= run;
+        while (run--)
+            stuffed_data[len++] = *(data++);
+        if (data_len) {
+            *checksum += *data;
+            len += sensirion_shdlc_stuff_data(1, data++, stuffed_data + len);
+            --data_len;
+        }
+    }
+    return len;
+}
+
+static void
+sensirion_shdlc_rx_parser_start(struct sensirion_shdlc_rx_parser* parser) {
+    parser->state = SENSIRION_SHDLC_RX_STATE_HEADER;
+    parser->escape = 0;
+    parser->position = 0;
+    parser->checksum = 0;
+}
+
+static int16_t
+sensirion_shdlc_rx_parser_byte(struct sensirion_shdlc_rx_parser* parser,
+                               uint8_t c) {
+    int16_t ret;
+
+    switch (parser->state) {
+        case SENSIRION_SHDLC_RX_STATE_HUNT:
+            if (c == SHDLC_START)
+                sensirion_shdlc_rx_parser_start(parser);
+            return SENSIRION_SHDLC_RX_INCOMPLETE;
+        case SENSIRION_SHDLC_RX_STATE_STOP:
+            parser->state = SENSIRION_SHDLC_RX_STATE_HUNT;
+            return c == SHDLC_STOP ? NO_ERROR
+                                   : SENSIRION_SHDLC_ERR_MISSING_STOP;
+        default:
+            break;
+    }
+
+    if (c == SHDLC_START) {
+        /* stop byte of a truncated frame or start of the next one, repeated
+         * start bytes before the header are fine */
+        ret = parser->state == SENSIRION_SHDLC_RX_STATE_HEADER &&
+                      parser->position == 0 && !parser->escape
+                  ? SENSIRION_SHDLC_RX_INCOMPLETE
+                  : SENSIRION_SHDLC_ERR_ENCODING_ERROR;
+        sensirion_shdlc_rx_parser_start(parser);
+        return ret;
+    }
+
+    if (parser->escape) {
+        /* byte stuffing is undone by inverting bit 5 */
+        c ^= (1 << 5);
+        parser->escape = 0;
+    } else if (c == 0x7d) {
+        parser->escape = 1;
+        return SENSIRION_SHDLC_RX_INCOMPLETE;
+    }
+    parser->checksum += c;
+
+    switch (parser->state) {
+        case SENSIRION_SHDLC_RX_STATE_HEADER:
+            switch (parser->position++) {
+                case 0:
+                    parser->header.addr = c;
+                    break;
+                case 1:
+                    parser->header.cmd = c;
+                    break;
+                case 2:
+                    parser->header.state = c;
+                    break;
+                default:
+                    parser->header.data_len = c;
+                    if (c > parser->max_data_len) {
+                        parser->state = SENSIRION_SHDLC_RX_STATE_HUNT;
+                        return SENSIRION_SHDLC_ERR_FRAME_TOO_LONG;
+                    }
+                    parser->position = 0;
+                    parser->state = c ? SENSIRION_SHDLC_RX_STATE_DATA
+                                      : SENSIRION_SHDLC_RX_STATE_CHECKSUM;
+            }
+            return SENSIRION_SHDLC_RX_INCOMPLETE;
+        case SENSIRION_SHDLC_RX_STATE_DATA:
+            parser->data[parser->position++] = c;
+            if (parser->position == parser->header.data_len)
+                parser->state = SENSIRION_SHDLC_RX_STATE_CHECKSUM;
+            return SENSIRION_SHDLC_RX_INCOMPLETE;
         default:
-            return data;
+            /* (CHECKSUM + ~CHECKSUM) = 0xFF */
+            if (parser->checksum != 0xFF) {
+                parser->state = SENSIRION_SHDLC_RX_STATE_HUNT;
+                return SENSIRION_SHDLC_ERR_CRC_MISMATCH;
+            }
+            parser->state = SENSIRION_SHDLC_RX_STATE_STOP;
+            return SENSIRION_SHDLC_RX_INCOMPLETE;
+    }
+}
+
+static struct sensirion_shdlc_rx_buffer*
+sensirion_shdlc_rx_buffer(struct sensirion_shdlc_port* port) {
+    return port ? &port->rx_buffer : &default_port.rx_buffer;
+}
+
+/* feed bytes left in the receive buffer to the parser, then refill the buffer
+ * from the port until the parser completes a frame or max_frame_size bytes
+ * were read. Bytes after the frame stay in the buffer. Without timeout the
+ * reads block, otherwise they are only done once the port reports data (or
+ * block if the port can't report it). */
+static int16_t
+sensirion_shdlc_port_receive(struct sensirion_shdlc_port* port,
+                             struct sensirion_shdlc_rx_parser* parser,
+                             uint16_t max_frame_size, uint32_t timeout_us) {
+    struct sensirion_shdlc_rx_buffer* rx = sensirion_shdlc_rx_buffer(port);
+    uint16_t received = 0;
+    uint16_t consumed;
+    int16_t len;
+    int16_t ready;
+    int16_t ret = SENSIRION_SHDLC_RX_INCOMPLETE;
+
+    for (;;) {
+        if (rx->count) {
+            ret = sensirion_shdlc_rx_parser_feed(parser, rx->data + rx->start,
+                                                 rx->count, &consumed);
+            rx->start += consumed;
+            rx->count -= consumed;
+        }
+        if (ret != SENSIRION_SHDLC_RX_INCOMPLETE || received >= max_frame_size)
+            break;
+
+        if (timeout_us) {
+            ready = sensirion_uart_hal_port_wait_rx(sensirion_shdlc_uart(port),
+                                                    timeout_us);
+            if (ready == 0) {
+                return SENSIRION_SHDLC_ERR_TIMEOUT;
+            } else if (ready < 0) {
+                return ready;
+            }
+        }
+        len = sensirion_uart_hal_port_rx(sensirion_shdlc_uart(port),
+                                         sizeof(rx->data), rx->data);
+        if (len < 1)
+            break;
+        rx->start = 0;
+        rx->count = (uint16_t)len;
+        received += (uint16_t)len;
+    }
+
+    if (ret == SENSIRION_SHDLC_RX_INCOMPLETE) {
+        return parser->state == SENSIRION_SHDLC_RX_STATE_HUNT
+                   ? SENSIRION_SHDLC_ERR_MISSING_START
+                   : SENSIRION_SHDLC_ERR_MISSING_STOP;
+    }
+    if (ret != NO_ERROR)
+        return ret;
+
+    if (0x7F & parser->header.state) {
+        return SENSIRION_SHDLC_ERR_EXECUTION_FAILURE;
     }
+    return NO_ERROR;
+}
+
+int16_t sensirion_shdlc_port_init(struct sensirion_shdlc_port* port,
+                                  const char* device) {
+    port->rx_buffer.start = 0;
+    port->rx_buffer.count = 0;
+    port->command_timings.count = 0;
+    return sensirion_uart_hal_port_init(&port->uart, device);
+}
+
+int16_t sensirion_shdlc_port_free(struct sensirion_shdlc_port* port) {
+    return sensirion_uart_hal_port_free(&port->uart);
 }
 
 int16_t sensirion_shdlc_xcv(uint8_t addr, uint8_t cmd, uint8_t tx_data_len,
                             const uint8_t* tx_data, uint8_t max_rx_data_len,
                             struct sensirion_shdlc_rx_header* rx_header,
                             uint8_t* rx_data) {
-    int16_t ret;
+    return sensirion_shdlc_port_xcv(NULL, addr, cmd, tx_data_len, tx_data,
+                                    max_rx_data_len, rx_header, rx_data);
+}
 
-    ret = sensirion_shdlc_tx(addr, cmd, tx_data_len, tx_data);
+int16_t sensirion_shdlc_port_xcv(struct sensirion_shdlc_port* port,
+                                 uint8_t addr, uint8_t cmd, uint8_t tx_data_len,
+                                 const uint8_t* tx_data,
+                                 uint8_t max_rx_data_len,
+                                 struct sensirion_shdlc_rx_header* rx_header,
+                                 uint8_t* rx_data) {
+    uint32_t timeout_us = SENSIRION_SHDLC_DEFAULT_TIMEOUT_US;
+    const struct sensirion_shdlc_command_timing* timing;
+
+    timing = sensirion_shdlc_find_command_timing(port, addr, cmd);
+    if (timing)
+        timeout_us = timing->timeout_us;
+    return sensirion_shdlc_port_xcv_timeout(port, addr, cmd, tx_data_len,
+                                            tx_data, max_rx_data_len,
+                                            rx_header, rx_data, timeout_us);
+}
+
+int16_t sensirion_shdlc_xcv_timeout(uint8_t addr, uint8_t cmd,
+                                    uint8_t tx_data_len, const uint8_t* tx_data,
+                                    uint8_t max_rx_data_len,
+                                    struct sensirion_shdlc_rx_header* rx_header,
+                                    uint8_t* rx_data, uint32_t timeout_us) {
+    return sensirion_shdlc_port_xcv_timeout(NULL, addr, cmd, tx_data_len,
+                                            tx_data, max_rx_data_len,
+                                            rx_header, rx_data, timeout_us);
+}
+
+int16_t sensirion_shdlc_port_xcv_timeout(
+    struct sensirion_shdlc_port* port, uint8_t addr, uint8_t cmd,
+    uint8_t tx_data_len, const uint8_t* tx_data, uint8_t max_rx_data_len,
+    struct sensirion_shdlc_rx_header* rx_header, uint8_t* rx_data,
+    uint32_t timeout_us) {
+    int16_t ret;
+    struct sensirion_shdlc_rx_parser parser;
+    struct sensirion_shdlc_command_timing* timing;
+    uint32_t expected_latency_us = SENSIRION_SHDLC_DEFAULT_LATENCY_US;
+    uint32_t start_us;
+    uint32_t latency_us;
+    uint32_t sleep_us = 0;
+    bool measure = false;
+
+    timing = sensirion_shdlc_find_command_timing(port, addr, cmd);
+    if (timing)
+        expected_latency_us = timing->expected_latency_us;
+
+    ret = sensirion_shdlc_port_tx(port, addr, cmd, tx_data_len, tx_data);
     if (ret != 0)
         return ret;
+    start_us = sensirion_uart_hal_get_time_usec();
+
+    /* the response may already be in the receive buffer */
+    if (timeout_us && !sensirion_shdlc_rx_buffer(port)->count) {
+        /* sleep through most of a known latency, so the response is read in
+         * one go instead of waking up on its first bytes. Ending the sleep
+         * early keeps the measured latency accurate. */
+        if (timing) {
+            sleep_us = expected_latency_us - expected_latency_us / 4;
+            if (sleep_us < timeout_us) {
+                sensirion_uart_hal_sleep_usec(sleep_us);
+                timeout_us -= sleep_us;
+            } else {
+                sleep_us = 0;
+            }
+        }
+        ret = sensirion_uart_hal_port_wait_rx(sensirion_shdlc_uart(port),
+                                              timeout_us);
+        if (ret == NOT_IMPLEMENTED_ERROR) {
+            /* give the device the expected time to answer, then block */
+            sensirion_uart_hal_sleep_usec(expected_latency_us - sleep_us);
+            timeout_us = 0;
+        } else if (ret == 0) {
+            return SENSIRION_SHDLC_ERR_TIMEOUT;
+        } else if (ret < 0) {
+            return ret;
+        } else {
+            measure = true;
+        }
+    }
+
+    sensirion_shdlc_rx_parser_init(&parser, max_rx_data_len, rx_data);
+    ret = sensirion_shdlc_port_receive(
+        port, &parser, 2 + (5 + (uint16_t)max_rx_data_len) * 2, timeout_us);
+    *rx_header = parser.header;
+
+    latency_us = sensirion_uart_hal_get_time_usec() - start_us;
+    /* a latency of 0 means there is no time source */
+    if (ret != NO_ERROR || !measure || !latency_us)
+        return ret;
+
+    if (timing) {
+        /* exponentially weighted moving average with weight 1/8 */
+        timing->expected_latency_us = timing->expected_latency_us -
+                                      timing->expected_latency_us / 8 +
+                                      latency_us / 8;
+    } else {
+        timing = sensirion_shdlc_add_command_timing(port, addr, cmd, false);
+        if (timing)
+            timing->expected_latency_us = latency_us;
+    }
+    return ret;
+}
 
-    sensirion_uart_hal_sleep_usec(RX_DELAY_US);
-    return sensirion_shdlc_rx(max_rx_data_len, rx_header, rx_data);
+int16_t sensirion_shdlc_set_command_timing(uint8_t addr, uint8_t cmd,
+                                           uint32_t expected_latency_us,
+                                           uint32_t timeout_us) {
+    return sensirion_shdlc_port_set_command_timing(NULL, addr, cmd,
+                                                   expected_latency_us,
+                                                   timeout_us);
+}
+
+int16_t sensirion_shdlc_port_set_command_timing(
+    struct sensirion_shdlc_port* port, uint8_t addr, uint8_t cmd,
+    uint32_t expected_latency_us, uint32_t timeout_us) {
+    struct sensirion_shdlc_command_timing* timing;
+
+    timing = sensirion_shdlc_find_command_timing(port, addr, cmd);
+    if (!timing)
+        timing = sensirion_shdlc_add_command_timing(port, addr, cmd, true);
+    if (!timing)
+        return SENSIRION_SHDLC_ERR_TIMING_TABLE_FULL;
+
+    timing->is_set = true;
+    timing->expected_latency_us = expected_latency_us;
+    timing->timeout_us = timeout_us;
+    return NO_ERROR;
+}
+
+void sensirion_shdlc_get_command_timing(uint8_t addr, uint8_t cmd,
+                                        uint32_t* expected_latency_us,
+                                        uint32_t* timeout_us) {
+    sensirion_shdlc_port_get_command_timing(NULL, addr, cmd,
+                                            expected_latency_us, timeout_us);
+}
+
+void sensirion_shdlc_port_get_command_timing(
+    struct sensirion_shdlc_port* port, uint8_t addr, uint8_t cmd,
+    uint32_t* expected_latency_us, uint32_t* timeout_us) {
+    const struct sensirion_shdlc_command_timing* timing;
+
+    timing = sensirion_shdlc_find_command_timing(port, addr, cmd);
+    if (timing) {
+        *expected_latency_us = timing->expected_latency_us;
+        *timeout_us = timing->timeout_us;
+    } else {
+        *expected_latency_us = SENSIRION_SHDLC_DEFAULT_LATENCY_US;
+        *timeout_us = SENSIRION_SHDLC_DEFAULT_TIMEOUT_US;
+    }
 }
 
 int16_t sensirion_shdlc_tx(uint8_t addr, uint8_t cmd, uint8_t data_len,
                            const uint8_t* data) {
+    return sensirion_shdlc_port_tx(NULL, addr, cmd, data_len, data);
+}
+
+/* send the frame with the runs of unstuffed data taken straight from the
+ * caller's memory, in several calls if it needs more segments than the HAL
+ * takes at once. NOT_IMPLEMENTED_ERROR if the HAL doesn't support it. */
+static int16_t sensirion_shdlc_port_tx_vec(struct sensirion_shdlc_port* port,
+                                           uint8_t addr, uint8_t cmd,
+                                           uint8_t data_len,
+                                           const uint8_t* data) {
+    struct sensirion_uart_hal_segment segments[SENSIRION_UART_HAL_MAX_SEGMENTS];
+    uint16_t num_segments = 0;
+    int16_t ret;
+    uint16_t run;
+    uint16_t len;
+    uint16_t i;
+    uint8_t crc = 0;
+    uint8_t header[3];
+    uint8_t head[1 + 2 * sizeof(header)];
+    uint8_t tail[2 + 1];
+
+    header[0] = addr;
+    header[1] = cmd;
+    header[2] = data_len;
+
+    head[0] = SHDLC_START;
+    segments[num_segments].data = head;
+    segments[num_segments++].length =
+        1 + sensirion_shdlc_stuff_bytes(header, sizeof(header), head + 1, &crc);
+
+    while (data_len) {
+        /* room for a run, a stuffed byte and the tail, otherwise send the
+         * segments so far. Only the first call can be NOT_IMPLEMENTED_ERROR,
+         * so nothing was sent when falling back to the buffered frame. */
+        if (num_segments + 3 > SENSIRION_UART_HAL_MAX_SEGMENTS) {
+            ret = sensirion_uart_hal_port_tx_vec(sensirion_shdlc_uart(port),
+                                                 segments, num_segments);
+            if (ret != 0)
+                return ret;
+            num_segments = 0;
+        }
+
+        run = sensirion_shdlc_unstuffed_run(data, data_len, &crc);
+        if (run) {
+            segments[num_segments].data = data;
+            segments[num_segments++].length = run;
+            data += run;
+            data_len -= (uint8_t)run;
+        }
+        if (data_len) {
+            i = 0;
+            while (shdlc_stuffed_bytes[i][0] != *data)
+                ++i;
+            segments[num_segments].data = &shdlc_stuffed_bytes[i][1];
+            segments[num_segments++].length = 2;
+            crc += *(data++);
+            --data_len;
+        }
+    }
+
+    crc = ~crc;
+    len = sensirion_shdlc_stuff_data(1, &crc, tail);
+    tail[len++] = SHDLC_STOP;
+    segments[num_segments].data = tail;
+    segments[num_segments++].length = len;
+
+    return sensirion_uart_hal_port_tx_vec(sensirion_shdlc_uart(port), segments,
+                                          num_segments);
+}
+
+static int16_t
+sensirion_shdlc_port_tx_buffered(struct sensirion_shdlc_port* port,
+                                 uint8_t addr, uint8_t cmd, uint8_t data_len,
+                                 const uint8_t* data) {
     uint16_t len = 0;
     int16_t ret;
-    uint8_t crc;
+    uint8_t crc = 0;
+    uint8_t header[3];
     uint8_t tx_frame_buf[SHDLC_FRAME_MAX_TX_FRAME_SIZE];
 
-    crc = sensirion_shdlc_checksum(addr + cmd, data_len, data);
+    header[0] = addr;
+    header[1] = cmd;
+    header[2] = data_len;
 
     tx_frame_buf[len++] = SHDLC_START;
-    len += sensirion_shdlc_stuff_data(1, &addr, tx_frame_buf + len);
-    len += sensirion_shdlc_stuff_data(1, &cmd, tx_frame_buf + len);
-    len += sensirion_shdlc_stuff_data(1, &data_len, tx_frame_buf + len);
-    len += sensirion_shdlc_stuff_data(data_len, data, tx_frame_buf + len);
+    len += sensirion_shdlc_stuff_bytes(header, sizeof(header),
+                                       tx_frame_buf + len, &crc);
+    len += sensirion_shdlc_stuff_bytes(data, data_len, tx_frame_buf + len,
+                                       &crc);
+    crc = ~crc;
     len += sensirion_shdlc_stuff_data(1, &crc, tx_frame_buf + len);
     tx_frame_buf[len++] = SHDLC_STOP;
 
-    ret = sensirion_uart_hal_tx(len, tx_frame_buf);
+    ret = sensirion_uart_hal_port_tx(sensirion_shdlc_uart(port), len,
+                                     tx_frame_buf);
     if (ret < 0)
         return ret;
     if (ret != len)
@@ -140,70 +621,114 @@ int16_t sensirion_shdlc_tx(uint8_t addr, uint8_t cmd, uint8_t data_len,
     return 0;
 }
 
+int16_t sensirion_shdlc_port_tx(struct sensirion_shdlc_port* port,
+                                uint8_t addr, uint8_t cmd, uint8_t data_len,
+                                const uint8_t* data) {
+    int16_t ret;
+
+#if SENSIRION_SHDLC_MAX_DATA_LENGTH < 255
+    if (data_len > SENSIRION_SHDLC_MAX_DATA_LENGTH)
+        return SENSIRION_SHDLC_ERR_FRAME_TOO_LONG;
+#endif
+
+    ret = sensirion_shdlc_port_tx_vec(port, addr, cmd, data_len, data);
+    if (ret != NOT_IMPLEMENTED_ERROR)
+        return ret;
+    return sensirion_shdlc_port_tx_buffered(port, addr, cmd, data_len, data);
+}
+
 int16_t sensirion_shdlc_rx(uint8_t max_data_len,
                            struct sensirion_shdlc_rx_header* rxh,
                            uint8_t* data) {
-    int16_t len;
-    uint16_t i;
-    uint8_t rx_frame[SHDLC_FRAME_MAX_RX_FRAME_SIZE];
-    uint8_t* rx_header = (uint8_t*)rxh;
-    uint8_t j;
-    uint8_t crc;
-    uint8_t unstuff_next;
-
-    len = sensirion_uart_hal_rx(2 + (5 + (uint16_t)max_data_len) * 2, rx_frame);
-    if (len < 1 || rx_frame[0] != SHDLC_START)
-        return SENSIRION_SHDLC_ERR_MISSING_START;
-
-    for (unstuff_next = 0, i = 1, j = 0; j < sizeof(*rxh) && i < len - 2; ++i) {
-        if (unstuff_next) {
-            rx_header[j++] = sensirion_shdlc_unstuff_byte(rx_frame[i]);
-            unstuff_next = 0;
-        } else {
-            unstuff_next = sensirion_shdlc_check_unstuff(rx_frame[i]);
-            if (!unstuff_next)
-                rx_header[j++] = rx_frame[i];
-        }
-    }
-    if (j != sizeof(*rxh) || unstuff_next)
-        return SENSIRION_SHDLC_ERR_ENCODING_ERROR;
-
-    if (max_data_len < rxh->data_len)
-        return SENSIRION_SHDLC_ERR_FRAME_TOO_LONG; /* more data than expected */
-
-    for (unstuff_next = 0, j = 0; j < rxh->data_len && i < len - 2; ++i) {
-        if (unstuff_next) {
-            data[j++] = sensirion_shdlc_unstuff_byte(rx_frame[i]);
-            unstuff_next = 0;
-        } else {
-            unstuff_next = sensirion_shdlc_check_unstuff(rx_frame[i]);
-            if (!unstuff_next)
-                data[j++] = rx_frame[i];
-        }
-    }
+    return sensirion_shdlc_port_rx(NULL, max_data_len, rxh, data);
+}
 
-    if (unstuff_next)
-        return SENSIRION_SHDLC_ERR_ENCODING_ERROR;
+int16_t sensirion_shdlc_port_rx(struct sensirion_shdlc_port* port,
+                                uint8_t max_data_len,
+                                struct sensirion_shdlc_rx_header* rxh,
+                                uint8_t* data) {
+    int16_t ret;
+    struct sensirion_shdlc_rx_parser parser;
 
-    if (j < rxh->data_len)
-        return SENSIRION_SHDLC_ERR_ENCODING_ERROR;
+    sensirion_shdlc_rx_parser_init(&parser, max_data_len, data);
+    ret = sensirion_shdlc_port_receive(port, &parser,
+                                       2 + (5 + (uint16_t)max_data_len) * 2, 0);
+    *rxh = parser.header;
+    return ret;
+}
 
-    crc = rx_frame[i++];
-    if (sensirion_shdlc_check_unstuff(crc))
-        crc = sensirion_shdlc_unstuff_byte(rx_frame[i++]);
+void sensirion_shdlc_rx_parser_init(struct sensirion_shdlc_rx_parser* parser,
+                                    uint8_t max_data_len, uint8_t* data) {
+    parser->header.addr = 0;
+    parser->header.cmd = 0;
+    parser->header.state = 0;
+    parser->header.data_len = 0;
+    parser->data = data;
+    parser->max_data_len = max_data_len < SENSIRION_SHDLC_MAX_DATA_LENGTH
+                               ? max_data_len
+                               : SENSIRION_SHDLC_MAX_DATA_LENGTH;
+    parser->state = SENSIRION_SHDLC_RX_STATE_HUNT;
+    parser->escape = 0;
+    parser->position = 0;
+    parser->checksum = 0;
+}
 
-    if (sensirion_shdlc_checksum(rxh->addr + rxh->cmd + rxh->state,
-                                 rxh->data_len, data) != crc)
-        return SENSIRION_SHDLC_ERR_CRC_MISMATCH;
+/* copy data bytes up to the first 0x7d or 0x7e and add them to the checksum.
+ * Returns the number of bytes taken, the rest is left to the bytewise parser.
+ * The data may be stored in front of the chunk in the same buffer. */
+static uint16_t
+sensirion_shdlc_rx_parser_data(struct sensirion_shdlc_rx_parser* parser,
+                               const uint8_t* chunk, uint16_t length) {
+    uint8_t* data = parser->data + parser->position;
+    uint16_t i = 0;
+    uint32_t word;
+    uint32_t sum;
+
+    if (length > (uint16_t)(parser->header.data_len - parser->position))
+        length = parser->header.data_len - parser->position;
+
+    for (; i + 4 <= length; i += 4) {
+        word = (uint32_t)chunk[i] | (uint32_t)chunk[i + 1] << 8 |
+               (uint32_t)chunk[i + 2] << 16 | (uint32_t)chunk[i + 3] << 24;
+        if (SHDLC_HAS_ZERO_BYTE(word ^ (uint32_t)0x7D7D7D7D) ||
+            SHDLC_HAS_ZERO_BYTE(word ^ (uint32_t)0x7E7E7E7E))
+            break;
+        data[i] = (uint8_t)word;
+        data[i + 1] = (uint8_t)(word >> 8);
+        data[i + 2] = (uint8_t)(word >> 16);
+        data[i + 3] = (uint8_t)(word >> 24);
+        sum = (word & 0x00FF00FF) + ((word >> 8) & 0x00FF00FF);
+        parser->checksum += (uint8_t)(sum + (sum >> 16));
+    }
+    for (; i < length && chunk[i] != 0x7d && chunk[i] != SHDLC_STOP; ++i) {
+        data[i] = chunk[i];
+        parser->checksum += chunk[i];
+    }
 
-    if (i >= len || rx_frame[i] != SHDLC_STOP)
-        return SENSIRION_SHDLC_ERR_MISSING_STOP;
+    parser->position += (uint8_t)i;
+    if (parser->position == parser->header.data_len)
+        parser->state = SENSIRION_SHDLC_RX_STATE_CHECKSUM;
+    return i;
+}
 
-    if (0x7F & rxh->state) {
-        return SENSIRION_SHDLC_ERR_EXECUTION_FAILURE;
+int16_t sensirion_shdlc_rx_parser_feed(struct sensirion_shdlc_rx_parser* parser,
+                                       const uint8_t* chunk, uint16_t length,
+                                       uint16_t* consumed) {
+    int16_t ret = SENSIRION_SHDLC_RX_INCOMPLETE;
+    uint16_t i = 0;
+
+    while (i < length && ret == SENSIRION_SHDLC_RX_INCOMPLETE) {
+        /* runs of data without stuffed bytes are taken at once */
+        if (parser->state == SENSIRION_SHDLC_RX_STATE_DATA && !parser->escape) {
+            i += sensirion_shdlc_rx_parser_data(parser, chunk + i, length - i);
+            if (i == length || parser->state != SENSIRION_SHDLC_RX_STATE_DATA)
+                continue;
+        }
+        ret = sensirion_shdlc_rx_parser_byte(parser, chunk[i++]);
     }
-
-    return 0;
+    if (consumed)
+        *consumed = i;
+    return ret;
 }
 
 static void sensirion_shdlc_stuff_byte(struct sensirion_shdlc_buffer* tx_frame,
@@ -295,11 +820,9 @@ void sensirion_shdlc_add_float_to_frame(struct sensirion_shdlc_buffer* tx_frame,
 void sensirion_shdlc_add_bytes_to_frame(struct sensirion_shdlc_buffer* tx_frame,
                                         const uint8_t* data,
                                         uint16_t data_length) {
-    uint16_t i;
-
-    for (i = 0; i < data_length; i++) {
-        sensirion_shdlc_add_uint8_t_to_frame(tx_frame, data[i]);
-    }
+    tx_frame->offset += sensirion_shdlc_stuff_bytes(
+        data, data_length, tx_frame->data + tx_frame->offset,
+        &tx_frame->checksum);
 }
 
 void sensirion_shdlc_finish_frame(struct sensirion_shdlc_buffer* tx_frame) {
@@ -308,10 +831,16 @@ void sensirion_shdlc_finish_frame(struct sensirion_shdlc_buffer* tx_frame) {
 }
 
 int16_t sensirion_shdlc_tx_frame(struct sensirion_shdlc_buffer* tx_frame) {
+    return sensirion_shdlc_port_tx_frame(NULL, tx_frame);
+}
+
+int16_t sensirion_shdlc_port_tx_frame(struct sensirion_shdlc_port* port,
+                                      struct sensirion_shdlc_buffer* tx_frame) {
 
     int16_t tx_length;
 
-    tx_length = sensirion_uart_hal_tx(tx_frame->offset, tx_frame->data);
+    tx_length = sensirion_uart_hal_port_tx(sensirion_shdlc_uart(port),
+                                           tx_frame->offset, tx_frame->data);
     if (tx_length < 0) {
         return tx_length;
     }
@@ -321,66 +850,27 @@ int16_t sensirion_shdlc_tx_frame(struct sensirion_shdlc_buffer* tx_frame) {
     return NO_ERROR;
 }
 
-static uint8_t
-sensirion_shdlc_unstuff_next_byte(struct sensirion_shdlc_buffer* rx_frame) {
-
-    uint8_t data = rx_frame->data[rx_frame->offset++];
-
-    if (data == 0x7d) {
-        data = rx_frame->data[rx_frame->offset++];
-        data = data ^ (1 << 5);
-    }
-    rx_frame->checksum += data;
-    return data;
-}
-
 int16_t sensirion_shdlc_rx_inplace(struct sensirion_shdlc_buffer* rx_frame,
                                    uint8_t expected_data_length,
                                    struct sensirion_shdlc_rx_header* header) {
-    int16_t rx_length;
-    uint16_t i;
-    rx_frame->offset = 0;
-    rx_frame->checksum = 0;
-
-    rx_length = sensirion_uart_hal_rx(
-        2 + (5 + (uint16_t)expected_data_length) * 2, rx_frame->data);
-    if (rx_length < 1 || rx_frame->data[rx_frame->offset++] != SHDLC_START) {
-        return SENSIRION_SHDLC_ERR_MISSING_START;
-    }
-
-    header->addr = sensirion_shdlc_unstuff_next_byte(rx_frame);
-    header->cmd = sensirion_shdlc_unstuff_next_byte(rx_frame);
-    header->state = sensirion_shdlc_unstuff_next_byte(rx_frame);
-    header->data_len = sensirion_shdlc_unstuff_next_byte(rx_frame);
-
-    if (expected_data_length < header->data_len) {
-        return SENSIRION_SHDLC_ERR_FRAME_TOO_LONG; /* more data than
-                                                      expected */
-    }
-
-    for (i = 0; i < header->data_len && rx_frame->offset < rx_length - 2; i++) {
-        rx_frame->data[i] = sensirion_shdlc_unstuff_next_byte(rx_frame);
-    }
-
-    if (i < header->data_len) {
-        return SENSIRION_SHDLC_ERR_ENCODING_ERROR;
-    }
-
-    sensirion_shdlc_unstuff_next_byte(rx_frame);
-
-    /* (CHECKSUM + ~CHECKSUM) = 0xFF */
-    if (rx_frame->checksum != 0xFF) {
-        return SENSIRION_SHDLC_ERR_CRC_MISMATCH;
-    }
-
-    if (rx_frame->offset >= rx_length ||
-        rx_frame->data[rx_frame->offset] != SHDLC_STOP) {
-        return SENSIRION_SHDLC_ERR_MISSING_STOP;
-    }
-
-    if (0x7F & header->state) {
-        return SENSIRION_SHDLC_ERR_EXECUTION_FAILURE;
-    }
+    return sensirion_shdlc_port_rx_inplace(NULL, rx_frame, expected_data_length,
+                                           header);
+}
 
-    return NO_ERROR;
+int16_t
+sensirion_shdlc_port_rx_inplace(struct sensirion_shdlc_port* port,
+                                struct sensirion_shdlc_buffer* rx_frame,
+                                uint8_t expected_data_length,
+                                struct sensirion_shdlc_rx_header* header) {
+    int16_t ret;
+    struct sensirion_shdlc_rx_parser parser;
+
+    sensirion_shdlc_rx_parser_init(&parser, expected_data_length,
+                                   rx_frame->data);
+    ret = sensirion_shdlc_port_receive(
+        port, &parser, 2 + (5 + (uint16_t)expected_data_length) * 2, 0);
+    rx_frame->offset = parser.position;
+    rx_frame->checksum = parser.checksum;
+    *header = parser.header;
+    return ret;
 }
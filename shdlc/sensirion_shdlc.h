@@ -33,6 +33,7 @@
 #define SENSIRION_SHDLC_H
 
 #include "sensirion_config.h"
+#include "sensirion_uart_hal.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,6 +47,24 @@ extern "C" {
 #define SENSIRION_SHDLC_ERR_TX_INCOMPLETE -6
 #define SENSIRION_SHDLC_ERR_FRAME_TOO_LONG -7
 #define SENSIRION_SHDLC_ERR_EXECUTION_FAILURE -8
+#define SENSIRION_SHDLC_ERR_TIMEOUT -9
+#define SENSIRION_SHDLC_ERR_TIMING_TABLE_FULL -10
+
+/* time sensirion_shdlc_xcv() waits for the response to start and to continue
+ * if no other timeout is set with sensirion_shdlc_set_command_timing() */
+#define SENSIRION_SHDLC_DEFAULT_TIMEOUT_US 1000000
+
+/* initial expected response time of commands without configured timing */
+#define SENSIRION_SHDLC_DEFAULT_LATENCY_US 20000
+
+/* returned by sensirion_shdlc_rx_parser_feed() until a frame is complete */
+#define SENSIRION_SHDLC_RX_INCOMPLETE 1
+
+#define SENSIRION_SHDLC_RX_STATE_HUNT 0     /* waiting for the start byte */
+#define SENSIRION_SHDLC_RX_STATE_HEADER 1   /* address, command, state, len */
+#define SENSIRION_SHDLC_RX_STATE_DATA 2     /* data_len data bytes */
+#define SENSIRION_SHDLC_RX_STATE_CHECKSUM 3 /* checksum byte */
+#define SENSIRION_SHDLC_RX_STATE_STOP 4     /* stop byte */
 
 struct sensirion_shdlc_buffer {
     uint8_t* data;
@@ -60,12 +79,27 @@ struct sensirion_shdlc_rx_header {
     uint8_t data_len;
 };
 
+/**
+ * Resumable receiver for one SHDLC frame at a time, which is fed with the
+ * received bytes in chunks of any size. Initialize with
+ * sensirion_shdlc_rx_parser_init().
+ */
+struct sensirion_shdlc_rx_parser {
+    struct sensirion_shdlc_rx_header header;
+    uint8_t* data;
+    uint8_t max_data_len;
+    uint8_t state;    /* one of SENSIRION_SHDLC_RX_STATE_* */
+    uint8_t escape;   /* 0x7d received, the next byte is stuffed */
+    uint8_t position; /* received bytes of the header or the data */
+    uint8_t checksum;
+};
+
 /**
  * sensirion_shdlc_tx() - transmit an SHDLC frame
  *
  * @addr:       SHDLC recipient address
  * @cmd:        command parameter
- * @data_len:   data length to send
+ * @data_len:   data length to send, at most SENSIRION_SHDLC_MAX_DATA_LENGTH
  * @data:       data to send
  * Return:      0 on success, an error code otherwise
  */
@@ -106,6 +140,81 @@ int16_t sensirion_shdlc_xcv(uint8_t addr, uint8_t cmd, uint8_t tx_data_len,
                             struct sensirion_shdlc_rx_header* rx_header,
                             uint8_t* rx_data);
 
+/**
+ * sensirion_shdlc_xcv_timeout() - transceive an SHDLC frame and receive the
+ *                                 response as soon as it arrives
+ *
+ * Instead of waiting a fixed time for the response like sensirion_shdlc_xcv()
+ * on platforms without sensirion_uart_hal_port_wait_rx(), the response is read
+ * as soon as the UART reports received data and is complete with its stop
+ * byte. sensirion_shdlc_xcv() uses the timeout of the command, see
+ * sensirion_shdlc_set_command_timing().
+ *
+ * Note that rx_header and rx_data must be discarded on failure
+ *
+ * @addr:           recipient address
+ * @cmd:            parameter
+ * @tx_data_len:    data length to send
+ * @tx_data:        data to send
+ * @rx_header:      Memory where the SHDLC header containing the sender address,
+ *                  command, sensor state and data length is stored
+ * @rx_data:        Memory where the received data is stored
+ * @timeout_us:     Max time in microseconds to wait for the start of the
+ *                  response and between its parts
+ * Return:          0 on success, SENSIRION_SHDLC_ERR_TIMEOUT if the response
+ *                  did not arrive in time, an error code otherwise
+ */
+int16_t sensirion_shdlc_xcv_timeout(uint8_t addr, uint8_t cmd,
+                                    uint8_t tx_data_len, const uint8_t* tx_data,
+                                    uint8_t max_rx_data_len,
+                                    struct sensirion_shdlc_rx_header* rx_header,
+                                    uint8_t* rx_data, uint32_t timeout_us);
+
+/**
+ * sensirion_shdlc_set_command_timing() - set the timing of a command
+ *
+ * sensirion_shdlc_xcv() looks up the timing of each address and command pair.
+ * Commands without timing use SENSIRION_SHDLC_DEFAULT_LATENCY_US and
+ * SENSIRION_SHDLC_DEFAULT_TIMEOUT_US. Each port has its own table of
+ * SENSIRION_SHDLC_MAX_COMMAND_TIMINGS entries. Commands are added to it when
+ * their timing is set or their response time is measured. A set timing
+ * replaces a measured one if the table is full.
+ *
+ * On platforms without sensirion_uart_hal_port_wait_rx() the expected latency
+ * is slept before the response is read. Otherwise three quarters of the
+ * expected latency of a command in the table are slept, then the response is
+ * read as soon as it arrives. If sensirion_uart_hal_get_time_usec() is
+ * implemented, the expected latency follows the measured response times, so
+ * each command keeps its own latency. Commands not in the table are read as
+ * soon as the response arrives.
+ *
+ * @addr:                   device address
+ * @cmd:                    command
+ * @expected_latency_us:    expected time from sending the command until the
+ *                          response is received
+ * @timeout_us:             Max time in microseconds to wait for the start of
+ *                          the response and between its parts
+ * Return:                  0 on success, SENSIRION_SHDLC_ERR_TIMING_TABLE_FULL
+ *                          if all commands in the table have a set timing
+ */
+int16_t sensirion_shdlc_set_command_timing(uint8_t addr, uint8_t cmd,
+                                           uint32_t expected_latency_us,
+                                           uint32_t timeout_us);
+
+/**
+ * sensirion_shdlc_get_command_timing() - get the timing of a command
+ *
+ * Commands without timing report the default latency and timeout.
+ *
+ * @addr:                   device address
+ * @cmd:                    command
+ * @expected_latency_us:    Memory where the expected latency is stored
+ * @timeout_us:             Memory where the timeout is stored
+ */
+void sensirion_shdlc_get_command_timing(uint8_t addr, uint8_t cmd,
+                                        uint32_t* expected_latency_us,
+                                        uint32_t* timeout_us);
+
 /**
  * sensirion_shdlc_add_uint8_t_to_frame() - Add a uint8_t to the frame at
  *                                          offset.
@@ -268,6 +377,155 @@ int16_t sensirion_shdlc_rx_inplace(struct sensirion_shdlc_buffer* rx_frame,
                                    uint8_t expected_data_length,
                                    struct sensirion_shdlc_rx_header* header);
 
+/**
+ * sensirion_shdlc_rx_parser_init() - Prepare a parser to receive a frame.
+ *
+ * @param parser       Parser to initialize
+ * @param max_data_len Size of the data buffer, longer frames than this or
+ *                     SENSIRION_SHDLC_MAX_DATA_LENGTH are rejected
+ * @param data         Memory where the received data is stored
+ */
+void sensirion_shdlc_rx_parser_init(struct sensirion_shdlc_rx_parser* parser,
+                                    uint8_t max_data_len, uint8_t* data);
+
+/**
+ * sensirion_shdlc_rx_parser_feed() - Process received bytes.
+ *
+ * Bytes before the start byte of a frame are skipped. As soon as the stop byte
+ * of a frame arrives the frame is reported and the remaining bytes of the
+ * chunk are left for the next frame. After a complete frame or an error the
+ * parser starts over with the next frame, it does not need to be initialized
+ * again.
+ *
+ * @note The header and data must be discarded on failure
+ *
+ * @param parser   Parser initialized with sensirion_shdlc_rx_parser_init()
+ * @param chunk    Received bytes
+ * @param length   Number of bytes in chunk
+ * @param consumed Memory to store the number of processed bytes of the chunk
+ *                 in. Can be NULL.
+ *
+ * @return NO_ERROR if a frame is complete, its header and data are stored in
+ *         parser->header and parser->data. SENSIRION_SHDLC_RX_INCOMPLETE if
+ *         all bytes are processed without completing a frame, a negative
+ *         error code if the frame is broken.
+ */
+int16_t sensirion_shdlc_rx_parser_feed(struct sensirion_shdlc_rx_parser* parser,
+                                       const uint8_t* chunk, uint16_t length,
+                                       uint16_t* consumed);
+
+/**
+ * Received bytes which were not yet parsed, e.g. the start of the next frame.
+ */
+struct sensirion_shdlc_rx_buffer {
+    uint8_t data[SENSIRION_SHDLC_RX_BUFFER_SIZE];
+    uint16_t start; /* offset of the first byte not yet parsed */
+    uint16_t count; /* number of bytes not yet parsed */
+};
+
+/**
+ * Timing of one command sent over the port, see
+ * sensirion_shdlc_set_command_timing().
+ */
+struct sensirion_shdlc_command_timing {
+    uint8_t addr;
+    uint8_t cmd;
+    bool is_set; /* set explicitly, not only measured */
+    uint32_t expected_latency_us;
+    uint32_t timeout_us;
+};
+
+/**
+ * Timings of the commands sent over the port.
+ */
+struct sensirion_shdlc_command_timings {
+    struct sensirion_shdlc_command_timing
+        entries[SENSIRION_SHDLC_MAX_COMMAND_TIMINGS];
+    uint16_t count;
+};
+
+/**
+ * Handle of one serial port for the port handle variants below. It holds the
+ * UART handle of the HAL and the state the SHDLC driver keeps per port.
+ */
+struct sensirion_shdlc_port {
+    struct sensirion_uart_hal_port uart;
+    struct sensirion_shdlc_rx_buffer rx_buffer;
+    struct sensirion_shdlc_command_timings command_timings;
+};
+
+/**
+ * sensirion_shdlc_port_init() - initialize a port handle and its UART
+ *
+ * Empties the receive buffer and the command timings of the port and
+ * initializes the UART handle with sensirion_uart_hal_port_init().
+ *
+ * @param port   Port handle to initialize
+ * @param device Platform specific name of the port, e.g. "/dev/ttyUSB0"
+ *
+ * @return 0 on success, an error code otherwise
+ */
+int16_t sensirion_shdlc_port_init(struct sensirion_shdlc_port* port,
+                                  const char* device);
+
+/**
+ * sensirion_shdlc_port_free() - release the resources of a port handle
+ *
+ * @param port Port handle to release
+ *
+ * @return 0 on success, an error code otherwise
+ */
+int16_t sensirion_shdlc_port_free(struct sensirion_shdlc_port* port);
+
+/*
+ * Port handle variants
+ *
+ * The following functions behave like their counterparts without "port_" in
+ * the name, but communicate on the given serial port instead of the default
+ * port. This allows to drive several ports in parallel, e.g. one per thread.
+ * The port handle is initialized with sensirion_shdlc_port_init(), NULL
+ * selects the default port.
+ */
+
+int16_t sensirion_shdlc_port_tx(struct sensirion_shdlc_port* port,
+                                uint8_t addr, uint8_t cmd, uint8_t data_len,
+                                const uint8_t* data);
+
+int16_t sensirion_shdlc_port_rx(struct sensirion_shdlc_port* port,
+                                uint8_t max_data_len,
+                                struct sensirion_shdlc_rx_header* header,
+                                uint8_t* data);
+
+int16_t sensirion_shdlc_port_xcv(struct sensirion_shdlc_port* port,
+                                 uint8_t addr, uint8_t cmd, uint8_t tx_data_len,
+                                 const uint8_t* tx_data,
+                                 uint8_t max_rx_data_len,
+                                 struct sensirion_shdlc_rx_header* rx_header,
+                                 uint8_t* rx_data);
+
+int16_t sensirion_shdlc_port_xcv_timeout(
+    struct sensirion_shdlc_port* port, uint8_t addr, uint8_t cmd,
+    uint8_t tx_data_len, const uint8_t* tx_data, uint8_t max_rx_data_len,
+    struct sensirion_shdlc_rx_header* rx_header, uint8_t* rx_data,
+    uint32_t timeout_us);
+
+int16_t sensirion_shdlc_port_set_command_timing(
+    struct sensirion_shdlc_port* port, uint8_t addr, uint8_t cmd,
+    uint32_t expected_latency_us, uint32_t timeout_us);
+
+void sensirion_shdlc_port_get_command_timing(
+    struct sensirion_shdlc_port* port, uint8_t addr, uint8_t cmd,
+    uint32_t* expected_latency_us, uint32_t* timeout_us);
+
+int16_t sensirion_shdlc_port_tx_frame(struct sensirion_shdlc_port* port,
+                                      struct sensirion_shdlc_buffer* tx_frame);
+
+int16_t
+sensirion_shdlc_port_rx_inplace(struct sensirion_shdlc_port* port,
+                                struct sensirion_shdlc_buffer* rx_frame,
+                                uint8_t expected_data_length,
+                                struct sensirion_shdlc_rx_header* header);
+
 #ifdef __cplusplus
 }
 #endif
@@ -85,6 +85,132 @@ int16_t sensirion_uart_hal_rx(uint16_t max_data_len, uint8_t* data) {
     return NOT_IMPLEMENTED_ERROR;
 }
 
+/**
+ * sensirion_uart_hal_port_init() - initialize a port handle and the UART
+ *
+ * @port:       port handle to initialize
+ * @device:     platform specific name of the port, e.g. "/dev/ttyUSB0"
+ * Return:      0 on success, an error code otherwise
+ */
+int16_t sensirion_uart_hal_port_init(struct sensirion_uart_hal_port* port,
+                                     const char* device) {
+    /* TODO: implement or leave as is on single-port setups */
+    port->device = device;
+    port->handle = 0;
+    return NO_ERROR;
+}
+
+/**
+ * sensirion_uart_hal_port_free() - release the resources of a port handle
+ *
+ * @port:       port handle to release
+ * Return:      0 on success, an error code otherwise
+ */
+int16_t sensirion_uart_hal_port_free(struct sensirion_uart_hal_port* port) {
+    /* TODO: implement or leave as is on single-port setups */
+    return NO_ERROR;
+}
+
+/**
+ * sensirion_uart_hal_port_set_baudrate() - change the baudrate of a port
+ *
+ * Used to follow the device after switching its baudrate with the respective
+ * SHDLC command. THE IMPLEMENTATION IS OPTIONAL, return NOT_IMPLEMENTED_ERROR
+ * if the baudrate can't be changed at runtime.
+ *
+ * @port:       port handle or NULL for the default port
+ * @baudrate:   new baudrate in bit/s
+ * Return:      0 on success, NOT_IMPLEMENTED_ERROR or a negative error code
+ *              otherwise
+ */
+int16_t sensirion_uart_hal_port_set_baudrate(
+    struct sensirion_uart_hal_port* port, uint32_t baudrate) {
+    /* TODO: implement or leave as is */
+    return NOT_IMPLEMENTED_ERROR;
+}
+
+/**
+ * sensirion_uart_hal_port_tx() - same as sensirion_uart_hal_tx() on the given
+ *                                port
+ *
+ * @port:       port handle or NULL for the default port
+ * @data_len:   number of bytes to send
+ * @data:       data to send
+ * Return:      Number of bytes sent or a negative error code
+ */
+int16_t sensirion_uart_hal_port_tx(struct sensirion_uart_hal_port* port,
+                                   uint16_t data_len, const uint8_t* data) {
+    /* TODO: implement or leave as is on single-port setups */
+    return sensirion_uart_hal_tx(data_len, data);
+}
+
+/**
+ * sensirion_uart_hal_port_rx() - same as sensirion_uart_hal_rx() on the given
+ *                                port
+ *
+ * @port:       port handle or NULL for the default port
+ * @data_len:   max number of bytes to receive
+ * @data:       Memory where received data is stored
+ * Return:      Number of bytes received or a negative error code
+ */
+int16_t sensirion_uart_hal_port_rx(struct sensirion_uart_hal_port* port,
+                                   uint16_t max_data_len, uint8_t* data) {
+    /* TODO: implement or leave as is on single-port setups */
+    return sensirion_uart_hal_rx(max_data_len, data);
+}
+
+/**
+ * sensirion_uart_hal_port_tx_vec() - send several memory segments at once
+ *
+ * The segments are sent back to back as if they were one buffer, e.g. with
+ * writev(). THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR to
+ * let the caller copy the segments into one buffer for
+ * sensirion_uart_hal_port_tx() instead.
+ *
+ * @port:           port handle or NULL for the default port
+ * @segments:       at most SENSIRION_UART_HAL_MAX_SEGMENTS segments to send
+ * @num_segments:   number of segments
+ * Return:          0 if all data was sent, NOT_IMPLEMENTED_ERROR or a
+ *                  negative error code otherwise
+ */
+int16_t sensirion_uart_hal_port_tx_vec(
+    struct sensirion_uart_hal_port* port,
+    const struct sensirion_uart_hal_segment* segments, uint16_t num_segments) {
+    /* TODO: implement or leave as is */
+    return NOT_IMPLEMENTED_ERROR;
+}
+
+/**
+ * sensirion_uart_hal_port_wait_rx() - wait until data can be received
+ *
+ * THE IMPLEMENTATION IS OPTIONAL. Return NOT_IMPLEMENTED_ERROR to let the
+ * caller sleep for a fixed time instead.
+ *
+ * @port:       port handle or NULL for the default port
+ * @timeout_us: max time to wait in microseconds
+ * Return:      1 if data can be received, 0 on timeout, NOT_IMPLEMENTED_ERROR
+ *              or a negative error code otherwise
+ */
+int16_t sensirion_uart_hal_port_wait_rx(struct sensirion_uart_hal_port* port,
+                                        uint32_t timeout_us) {
+    /* TODO: implement or leave as is */
+    return NOT_IMPLEMENTED_ERROR;
+}
+
+/**
+ * sensirion_uart_hal_get_time_usec() - monotonic timestamp in microseconds
+ *
+ * The timestamp may wrap around, only differences between timestamps are
+ * used. THE IMPLEMENTATION IS OPTIONAL, return 0 if no time source is
+ * available. It is used to learn the response times of SHDLC commands.
+ *
+ * Return:      the current time in microseconds
+ */
+uint32_t sensirion_uart_hal_get_time_usec(void) {
+    /* TODO: implement or leave as is */
+    return 0;
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution for at least the given time, but may also sleep longer.
@@ -1,9 +1,17 @@
+#include "sensirion_common.h"
 #include "sensirion_i2c.h"
+#include "sensirion_i2c.hpp"
+#include "sensirion_i2c_scheduler.h"
 #include "sensirion_shdlc.h"
+#include "sensirion_test_i2c_hal.h"
 #include "sensirion_test_setup.h"
+#include "sensirion_test_uart_hal.h"
+
+#include <string.h>
 
 TEST_GROUP (EmbeddedCommon_SHDLC_Tests) {
     void setup() {
+        sensirion_test_uart_hal_reset();
     }
 
     void teardown() {
@@ -11,6 +19,17 @@ TEST_GROUP (EmbeddedCommon_SHDLC_Tests) {
 };
 
 TEST_GROUP (EmbeddedCommon_I2C_Tests) {
+    void setup() {
+        /* fills the table of SENSIRION_I2C_CRC_ENGINE_WORD_TABLE */
+        sensirion_i2c_crc_init();
+        sensirion_test_i2c_hal_reset();
+    }
+
+    void teardown() {
+    }
+};
+
+TEST_GROUP (EmbeddedCommon_Common_Tests) {
     void setup() {
     }
 
@@ -121,3 +140,1007 @@ TEST (EmbeddedCommon_I2C_Tests, Frame_Test_2) {
     offset = sensirion_i2c_add_uint16_t_to_buffer(&buffer[0], offset, data2);
     MEMCMP_EQUAL(outdata, buffer, 8);
 }
+
+static uint8_t reference_crc(const uint8_t* data, uint16_t count) {
+    uint8_t crc = CRC8_INIT;
+    uint8_t bit;
+    for (uint16_t i = 0; i < count; ++i) {
+        crc ^= data[i];
+        for (bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ CRC8_POLYNOMIAL)
+                               : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+TEST (EmbeddedCommon_I2C_Tests, CRC_Datasheet_Example) {
+    const uint8_t data[] = {0xBE, 0xEF};
+    CHECK_EQUAL(0x92, sensirion_i2c_generate_crc(data, sizeof(data)));
+    CHECK_EQUAL_ZERO(sensirion_i2c_check_crc(data, sizeof(data), 0x92));
+    CHECK_EQUAL(CRC_ERROR, sensirion_i2c_check_crc(data, sizeof(data), 0x93));
+}
+
+TEST (EmbeddedCommon_I2C_Tests, CRC_All_Words) {
+    uint8_t word[2];
+    for (uint32_t i = 0; i <= 0xFFFF; ++i) {
+        word[0] = (uint8_t)(i >> 8);
+        word[1] = (uint8_t)i;
+        CHECK_EQUAL(reference_crc(word, 2),
+                    sensirion_i2c_generate_crc(word, 2));
+    }
+}
+
+TEST (EmbeddedCommon_I2C_Tests, CRC_Odd_Lengths) {
+    const uint8_t data[] = {0x00, 0x11, 0x7E, 0xFF, 0x80};
+    for (uint16_t count = 0; count <= sizeof(data); ++count) {
+        CHECK_EQUAL(reference_crc(data, count),
+                    sensirion_i2c_generate_crc(data, count));
+    }
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Verify_And_Compact_Inplace) {
+    uint8_t buffer[] = {0xBE, 0xEF, 0x92, 0x80, 0x00, 0xA2, 0x66, 0x66, 0x93};
+    const uint8_t expected[] = {0xBE, 0xEF, 0x80, 0x00, 0x66, 0x66};
+    uint8_t mask = 0xFF;
+    CHECK_EQUAL_ZERO(
+        sensirion_i2c_verify_and_compact(buffer, buffer, 3, &mask));
+    MEMCMP_EQUAL(expected, buffer, sizeof(expected));
+    CHECK_EQUAL(0x00, mask);
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Verify_And_Compact_Error_Mask) {
+    const uint16_t num_words = 10;
+    uint8_t frame[10 * 3];
+    uint8_t data[10 * 2];
+    uint8_t mask[2];
+    uint16_t offset = 0;
+    for (uint16_t i = 0; i < num_words; ++i) {
+        offset = sensirion_i2c_add_uint16_t_to_buffer(frame, offset,
+                                                      (uint16_t)(i * 0x1111));
+    }
+    frame[1 * 3 + 2] ^= 0x01; /* CRC of word 1 */
+    frame[9 * 3 + 0] ^= 0x80; /* MSB of word 9 */
+    CHECK_EQUAL(CRC_ERROR,
+                sensirion_i2c_verify_and_compact(frame, data, num_words, mask));
+    CHECK_EQUAL(0x02, mask[0]);
+    CHECK_EQUAL(0x02, mask[1]);
+    for (uint16_t i = 0; i < num_words - 1; ++i) {
+        CHECK_EQUAL((uint16_t)(i * 0x1111),
+                    sensirion_common_bytes_to_uint16_t(&data[i * 2]));
+    }
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Expand_With_CRC_Matches_Add_Functions) {
+    uint8_t payload[64];
+    uint8_t expected[96];
+    uint8_t buffer[96];
+    uint16_t offset = 0;
+    uint16_t i;
+    for (i = 0; i < sizeof(payload); ++i) {
+        payload[i] = (uint8_t)(i * 37 + 11);
+    }
+    for (i = 0; i < sizeof(payload); i += 2) {
+        offset = sensirion_i2c_add_uint16_t_to_buffer(
+            expected, offset, sensirion_common_bytes_to_uint16_t(&payload[i]));
+    }
+    CHECK_EQUAL(sizeof(expected), offset);
+    CHECK_EQUAL(sizeof(buffer),
+                sensirion_i2c_expand_with_crc(payload, buffer, 32));
+    MEMCMP_EQUAL(expected, buffer, sizeof(expected));
+
+    memset(buffer, 0, sizeof(buffer));
+    offset = sensirion_i2c_add_bytes_to_buffer(buffer, 0, payload,
+                                               sizeof(payload));
+    CHECK_EQUAL(sizeof(expected), offset);
+    MEMCMP_EQUAL(expected, buffer, sizeof(expected));
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Expand_With_CRC_Matches_32bit_Encoders) {
+    uint8_t bytes[4];
+    uint8_t expected[6];
+    uint8_t buffer[6];
+
+    sensirion_common_uint32_t_to_bytes(0xDEADBEEF, bytes);
+    sensirion_i2c_add_uint32_t_to_buffer(expected, 0, 0xDEADBEEF);
+    sensirion_i2c_expand_with_crc(bytes, buffer, 2);
+    MEMCMP_EQUAL(expected, buffer, sizeof(expected));
+
+    sensirion_common_float_to_bytes(-12.5f, bytes);
+    sensirion_i2c_add_float_to_buffer(expected, 0, -12.5f);
+    sensirion_i2c_expand_with_crc(bytes, buffer, 2);
+    MEMCMP_EQUAL(expected, buffer, sizeof(expected));
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Constexpr_Command_Frame) {
+    static constexpr auto frame =
+        sensirion::i2c::command_frame<0x260F, 0x8000, 0x6666>();
+    static_assert(frame.size() == 8, "command + 2 * (word + crc)");
+    static_assert(sensirion::i2c::crc(0xBEEF) == 0x92, "datasheet example");
+    const uint16_t args[] = {0x8000, 0x6666};
+    uint8_t buffer[8];
+    CHECK_EQUAL(sizeof(buffer),
+                sensirion_i2c_fill_cmd_send_buf(buffer, 0x260F, args, 2));
+    MEMCMP_EQUAL(buffer, frame.data(), sizeof(buffer));
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Constexpr_Command_Without_Arguments) {
+    static constexpr auto frame = sensirion::i2c::command_frame<0x3615>();
+    const uint8_t expected[] = {0x36, 0x15};
+    static_assert(frame.size() == sizeof(expected), "command only");
+    MEMCMP_EQUAL(expected, frame.data(), sizeof(expected));
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Batch_Add) {
+    struct sensirion_i2c_hal_transfer transfers[2];
+    struct sensirion_i2c_batch batch;
+    const uint8_t command[] = {0x03, 0x00};
+    uint8_t buffer[9];
+    sensirion_i2c_batch_init(&batch, transfers, 2);
+    CHECK_EQUAL(BYTE_NUM_ERROR,
+                sensirion_i2c_batch_add(&batch, 0x61, command, sizeof(command),
+                                        buffer, 5));
+    /* 172 bytes take 258 bytes with CRC, more than a transfer can read */
+    CHECK_EQUAL(BYTE_NUM_ERROR,
+                sensirion_i2c_batch_add(&batch, 0x61, command, sizeof(command),
+                                        buffer, 172));
+    CHECK_EQUAL(BYTE_NUM_ERROR,
+                sensirion_i2c_batch_add(&batch, 0x61, command, 256, NULL, 0));
+    CHECK_EQUAL_ZERO(batch.num_transfers);
+    CHECK_EQUAL_ZERO(sensirion_i2c_batch_add(
+        &batch, 0x61, command, sizeof(command), buffer, 6));
+    CHECK_EQUAL_ZERO(sensirion_i2c_batch_add(&batch, 0x62, command,
+                                             sizeof(command), NULL, 0));
+    CHECK_EQUAL(BATCH_FULL_ERROR,
+                sensirion_i2c_batch_add(&batch, 0x63, command, sizeof(command),
+                                        buffer, 6));
+    CHECK_EQUAL(2, batch.num_transfers);
+    CHECK_EQUAL(9, transfers[0].rx_count);
+    CHECK_EQUAL(0x62, transfers[1].address);
+    CHECK_EQUAL(0, transfers[1].rx_count);
+}
+
+/* one write and read, one write, one read with bad CRC, one failing write and
+ * read and one successful write and read */
+static void add_batch_transfers(struct sensirion_i2c_batch* batch,
+                                uint8_t buffers[][6]) {
+    static const uint8_t command[] = {0x03, 0x00};
+    sensirion_test_i2c_hal.crc_error_address = 0x63;
+    sensirion_test_i2c_hal.fail_address = 0x64;
+    CHECK_EQUAL_ZERO(sensirion_i2c_batch_add(batch, 0x61, command,
+                                             sizeof(command), buffers[0], 4));
+    CHECK_EQUAL_ZERO(sensirion_i2c_batch_add(batch, 0x62, command,
+                                             sizeof(command), NULL, 0));
+    CHECK_EQUAL_ZERO(sensirion_i2c_batch_add(batch, 0x63, NULL, 0, buffers[2],
+                                             4));
+    CHECK_EQUAL_ZERO(sensirion_i2c_batch_add(batch, 0x64, command,
+                                             sizeof(command), buffers[3], 4));
+    CHECK_EQUAL_ZERO(sensirion_i2c_batch_add(batch, 0x65, command,
+                                             sizeof(command), buffers[4], 4));
+}
+
+static void check_batch_results(int16_t error, const int16_t* errors,
+                                uint8_t buffers[][6]) {
+    /* the first error is returned, errors has the one of every transfer */
+    CHECK_EQUAL(CRC_ERROR, error);
+    if (errors) {
+        CHECK_EQUAL(NO_ERROR, errors[0]);
+        CHECK_EQUAL(NO_ERROR, errors[1]);
+        CHECK_EQUAL(CRC_ERROR, errors[2]);
+        CHECK_EQUAL(I2C_BUS_ERROR, errors[3]);
+        CHECK_EQUAL(NO_ERROR, errors[4]);
+    }
+    /* the data is compacted in place */
+    CHECK_EQUAL(0x61, buffers[0][0]);
+    CHECK_EQUAL(0x00, buffers[0][1]);
+    CHECK_EQUAL(0x61, buffers[0][2]);
+    CHECK_EQUAL(0x01, buffers[0][3]);
+    CHECK_EQUAL(0x65, buffers[4][2]);
+    CHECK_EQUAL(0x01, buffers[4][3]);
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Batch_Execute_One_By_One) {
+    struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    struct sensirion_i2c_hal_transfer transfers[5];
+    struct sensirion_i2c_batch batch;
+    uint8_t buffers[5][6];
+    int16_t errors[5];
+    sensirion_i2c_batch_init(&batch, transfers, 5);
+    add_batch_transfers(&batch, buffers);
+    check_batch_results(sensirion_i2c_batch_execute(&batch, errors), errors,
+                        buffers);
+    CHECK_EQUAL(1, hal->num_transfer_calls);
+    CHECK_EQUAL_ZERO(batch.num_transfers);
+    /* without write_read the writes and reads are separate, the read of
+     * the failed write is skipped */
+    CHECK_EQUAL(7, hal->num_ops);
+    CHECK_EQUAL(0x61, hal->ops[0].address);
+    CHECK_EQUAL(2, hal->ops[0].tx_count);
+    CHECK_EQUAL(0x61, hal->ops[1].address);
+    CHECK_EQUAL(6, hal->ops[1].rx_count);
+    CHECK_EQUAL(0x64, hal->ops[4].address);
+    CHECK_EQUAL(0x65, hal->ops[5].address);
+
+    /* the batch can be filled again */
+    hal->num_ops = 0;
+    hal->has_write_read = true;
+    add_batch_transfers(&batch, buffers);
+    check_batch_results(sensirion_i2c_batch_execute(&batch, NULL), NULL,
+                        buffers);
+    CHECK_EQUAL(5, hal->num_ops);
+    CHECK_EQUAL(2, hal->ops[0].tx_count);
+    CHECK_EQUAL(6, hal->ops[0].rx_count);
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Batch_Execute_Transfer) {
+    struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    struct sensirion_i2c_hal_transfer transfers[5];
+    struct sensirion_i2c_batch batch;
+    uint8_t buffers[5][6];
+    int16_t errors[5];
+    hal->has_transfer = true;
+    sensirion_i2c_batch_init(&batch, transfers, 5);
+    add_batch_transfers(&batch, buffers);
+    check_batch_results(sensirion_i2c_batch_execute(&batch, errors), errors,
+                        buffers);
+    CHECK_EQUAL(1, hal->num_transfer_calls);
+    CHECK_EQUAL(5, hal->num_ops);
+    CHECK_EQUAL_ZERO(batch.num_transfers);
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Remaining_Usec_Wraps_Around) {
+    /* the stub HAL starts at time 0 */
+    CHECK_EQUAL(0u, sensirion_i2c_hal_get_time_usec());
+    CHECK_EQUAL(1000u, sensirion_i2c_remaining_usec(1000));
+    CHECK_EQUAL(0u, sensirion_i2c_remaining_usec(0));
+    CHECK_EQUAL(0u, sensirion_i2c_remaining_usec(0xFFFFFC18)); /* 1ms ago */
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Delayed_Read_Waits_On_Millisecond_Clock) {
+    struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    uint16_t data[2];
+    uint32_t start;
+    uint32_t delay;
+
+    /* the clock ticks at any point between command and read */
+    hal->tick_usec = 1000;
+    hal->op_usec = 90;
+    for (delay = 1; delay <= 2000; delay += 333) {
+        for (start = 0; start < 2000; start += 97) {
+            hal->num_ops = 0;
+            hal->slept_usec = 0;
+            hal->time_usec = start;
+            CHECK_EQUAL_ZERO(sensirion_i2c_delayed_read_cmd(0x44, 0x2400, delay,
+                                                            data, 2));
+            CHECK_EQUAL(2, hal->num_ops);
+            CHECK_EQUAL(delay, hal->slept_usec);
+            CHECK(hal->ops[1].time_usec - hal->ops[0].time_usec >= delay);
+            CHECK_EQUAL(0x4401, data[1]);
+        }
+    }
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Fetch_Waits_On_Millisecond_Clock) {
+    struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    uint16_t data[2];
+    uint32_t ready_at;
+    uint32_t start;
+    uint32_t delay;
+    uint32_t busy;
+
+    /* the clock ticks at any point between issue and fetch */
+    hal->tick_usec = 1000;
+    for (delay = 1; delay <= 2000; delay += 333) {
+        for (start = 0; start < 2000; start += 97) {
+            for (busy = 0; busy < 1500; busy += 250) {
+                hal->num_ops = 0;
+                hal->time_usec = start;
+                CHECK_EQUAL_ZERO(
+                    sensirion_i2c_issue_cmd(0x44, 0x2400, delay, &ready_at));
+                hal->time_usec += busy; /* e.g. talking to other sensors */
+                CHECK_EQUAL_ZERO(
+                    sensirion_i2c_fetch_words(0x44, ready_at, data, 2));
+                CHECK_EQUAL(2, hal->num_ops);
+                CHECK(hal->ops[1].time_usec - hal->ops[0].time_usec >= delay);
+                CHECK_EQUAL(0x4400, data[0]);
+            }
+        }
+    }
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Scheduler_Orders_By_Deadline) {
+    /* every command fails, every poll reports one command */
+    struct sensirion_i2c_scheduler_device* heap[2];
+    struct sensirion_i2c_scheduler_device slow;
+    struct sensirion_i2c_scheduler_device fast;
+    struct sensirion_i2c_scheduler_device* device;
+    struct sensirion_i2c_scheduler scheduler;
+    uint16_t data[2];
+    int i;
+    sensirion_test_i2c_hal.error = NOT_IMPLEMENTED_ERROR;
+    sensirion_i2c_scheduler_init(&scheduler, heap, 2);
+    sensirion_i2c_scheduler_device_init(&slow, NULL, 0x61, 0x0300, 50, 300,
+                                        data, 2);
+    sensirion_i2c_scheduler_device_init(&fast, NULL, 0x62, 0x0300, 50, 100,
+                                        data, 2);
+    CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_add(&scheduler, &slow));
+    CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_add(&scheduler, &fast));
+    CHECK_EQUAL(SCHEDULER_FULL_ERROR,
+                sensirion_i2c_scheduler_add(&scheduler, &fast));
+    /* starts at 0, 300 and 600 for slow and every 100 for fast */
+    for (i = 0; i < 10; ++i) {
+        CHECK_EQUAL(NOT_IMPLEMENTED_ERROR,
+                    sensirion_i2c_scheduler_poll(&scheduler, &device));
+        CHECK(device == &slow || device == &fast);
+    }
+    CHECK_EQUAL(3u, slow.num_errors);
+    CHECK_EQUAL(7u, fast.num_errors);
+    CHECK_EQUAL(700u, fast.next_start_us);
+}
+
+/* every read of the stub HAL comes at least delay_us after the last command
+ * to the same address */
+static void check_read_delays(uint8_t address, uint32_t delay_us) {
+    const struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    uint32_t written_at = 0;
+    uint16_t i;
+
+    for (i = 0; i < hal->num_ops; ++i) {
+        if (hal->ops[i].address != address)
+            continue;
+        if (hal->ops[i].tx_count)
+            written_at = hal->ops[i].time_usec;
+        else
+            CHECK(hal->ops[i].time_usec - written_at >= delay_us);
+    }
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Scheduler_Overlaps_Conversions) {
+    struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    struct sensirion_i2c_scheduler_device* heap[2];
+    struct sensirion_i2c_scheduler_device slow;
+    struct sensirion_i2c_scheduler_device fast;
+    struct sensirion_i2c_scheduler_device* device;
+    struct sensirion_i2c_scheduler scheduler;
+    uint16_t slow_data[2];
+    uint16_t fast_data[2];
+    uint16_t i;
+    hal->op_usec = 100;
+    sensirion_i2c_scheduler_init(&scheduler, heap, 2);
+    sensirion_i2c_scheduler_device_init(&slow, NULL, 0x61, 0x0300, 2000, 10000,
+                                        slow_data, 2);
+    sensirion_i2c_scheduler_device_init(&fast, NULL, 0x62, 0x0300, 2000, 5000,
+                                        fast_data, 2);
+    CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_add(&scheduler, &slow));
+    CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_add(&scheduler, &fast));
+    for (i = 0; i < 30; ++i) {
+        CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_poll(&scheduler, &device));
+        CHECK(device == &slow || device == &fast);
+    }
+    /* the fast command is sent while the slow sensor measures */
+    CHECK_EQUAL(0x61, hal->ops[0].address);
+    CHECK_EQUAL(2, hal->ops[0].tx_count);
+    CHECK_EQUAL(0x62, hal->ops[1].address);
+    CHECK_EQUAL(2, hal->ops[1].tx_count);
+    CHECK_EQUAL(0x61, hal->ops[2].address);
+    CHECK_EQUAL(6, hal->ops[2].rx_count);
+    CHECK_EQUAL(100u + 2000u + SENSIRION_I2C_HAL_TIME_RESOLUTION_USEC,
+                hal->ops[2].time_usec);
+    /* one operation after the other in the order of the deadlines */
+    for (i = 1; i < hal->num_ops; ++i)
+        CHECK(hal->ops[i].time_usec >= hal->ops[i - 1].time_usec + 100);
+    check_read_delays(0x61, 2000);
+    check_read_delays(0x62, 2000);
+
+    CHECK_EQUAL(10u, slow.num_samples);
+    CHECK_EQUAL(20u, fast.num_samples);
+    CHECK_EQUAL_ZERO(slow.num_errors + fast.num_errors);
+    CHECK_EQUAL(0x6101, slow_data[1]);
+    CHECK_EQUAL(0x6201, fast_data[1]);
+    /* the bus keeps up, starts are at most one operation late */
+    CHECK(slow.achieved_period_us >= 9900 && slow.achieved_period_us <= 10100);
+    CHECK(fast.achieved_period_us >= 4900 && fast.achieved_period_us <= 5100);
+    CHECK(slow.jitter_us <= 100);
+    CHECK(fast.jitter_us <= 100);
+    /* six operations of 100us every 10ms */
+    CHECK(sensirion_i2c_scheduler_bus_utilization(&scheduler) >= 55);
+    CHECK(sensirion_i2c_scheduler_bus_utilization(&scheduler) <= 65);
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Scheduler_Late_Start_Jitter) {
+    struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    struct sensirion_i2c_scheduler_device* heap[1];
+    struct sensirion_i2c_scheduler_device device;
+    struct sensirion_i2c_scheduler_device* polled;
+    struct sensirion_i2c_scheduler scheduler;
+    uint16_t data[2];
+    hal->op_usec = 100;
+    sensirion_i2c_scheduler_init(&scheduler, heap, 1);
+    sensirion_i2c_scheduler_device_init(&device, NULL, 0x61, 0x0300, 0, 5000,
+                                        data, 2);
+    CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_add(&scheduler, &device));
+    CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_poll(&scheduler, &polled));
+    /* the caller keeps the scheduler waiting, the second start is 800us late */
+    hal->time_usec = 5800;
+    CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_poll(&scheduler, &polled));
+    CHECK_EQUAL(5800u, device.last_start_us);
+    CHECK_EQUAL(5800u, device.achieved_period_us);
+    CHECK_EQUAL(800u / 16, device.jitter_us);
+    /* the next start is on time again, the averages move by 1/8 and 1/16 */
+    CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_poll(&scheduler, &polled));
+    CHECK_EQUAL(10000u, device.last_start_us);
+    CHECK_EQUAL(5800u - 5800u / 8 + 4200u / 8, device.achieved_period_us);
+    CHECK_EQUAL(50u - 50u / 16 + 800u / 16, device.jitter_us);
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Scheduler_Utilization_Window) {
+    struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    struct sensirion_i2c_scheduler_device* heap[1];
+    struct sensirion_i2c_scheduler_device device;
+    struct sensirion_i2c_scheduler_device* polled;
+    struct sensirion_i2c_scheduler scheduler;
+    uint16_t data[2];
+    uint16_t i;
+    /* two operations of 0.6s every minute for 40 minutes */
+    hal->op_usec = 600000;
+    sensirion_i2c_scheduler_init(&scheduler, heap, 1);
+    sensirion_i2c_scheduler_device_init(&device, NULL, 0x61, 0x0300, 1000,
+                                        60000000, data, 2);
+    CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_add(&scheduler, &device));
+    for (i = 0; i < 40; ++i)
+        CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_poll(&scheduler, &polled));
+    /* the window was halved but still covers the same load */
+    CHECK(scheduler.window_start_us > 0);
+    CHECK(sensirion_i2c_scheduler_bus_utilization(&scheduler) >= 19);
+    CHECK(sensirion_i2c_scheduler_bus_utilization(&scheduler) <= 21);
+}
+
+TEST (EmbeddedCommon_I2C_Tests, Scheduler_Waits_On_Millisecond_Clock) {
+    struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    struct sensirion_i2c_scheduler_device* heap[2];
+    struct sensirion_i2c_scheduler_device a;
+    struct sensirion_i2c_scheduler_device b;
+    struct sensirion_i2c_scheduler_device* device;
+    struct sensirion_i2c_scheduler scheduler;
+    uint16_t data[2];
+    uint32_t start;
+    uint16_t i;
+    hal->tick_usec = 1000;
+    hal->op_usec = 90;
+    for (start = 0; start < 2000; start += 97) {
+        hal->num_ops = 0;
+        hal->time_usec = start;
+        sensirion_i2c_scheduler_init(&scheduler, heap, 2);
+        sensirion_i2c_scheduler_device_init(&a, NULL, 0x61, 0x0300, 500, 3000,
+                                            data, 2);
+        sensirion_i2c_scheduler_device_init(&b, NULL, 0x62, 0x0300, 1500, 4000,
+                                            data, 2);
+        CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_add(&scheduler, &a));
+        CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_add(&scheduler, &b));
+        for (i = 0; i < 20; ++i)
+            CHECK_EQUAL_ZERO(sensirion_i2c_scheduler_poll(&scheduler, &device));
+        check_read_delays(0x61, 500);
+        check_read_delays(0x62, 1500);
+    }
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Rx_Parser_Chunks) {
+    /* MISO frame with stuffed data bytes 0x7E and 0x11 */
+    const uint8_t frame[] = {0x00, 0x7E, 0x00, 0x03, 0x00, 0x03, 0x01,
+                             0x7D, 0x5E, 0x7D, 0x31, 0x69, 0x7E, 0x7E};
+    const uint8_t expected[] = {0x01, 0x7E, 0x11};
+    struct sensirion_shdlc_rx_parser parser;
+    uint8_t data[3];
+    uint16_t chunk;
+    uint16_t offset;
+    uint16_t consumed;
+    int16_t ret;
+    for (chunk = 1; chunk <= sizeof(frame); ++chunk) {
+        sensirion_shdlc_rx_parser_init(&parser, sizeof(data), data);
+        ret = SENSIRION_SHDLC_RX_INCOMPLETE;
+        for (offset = 0; ret == SENSIRION_SHDLC_RX_INCOMPLETE;
+             offset += consumed) {
+            uint16_t length = sizeof(frame) - offset;
+            ret = sensirion_shdlc_rx_parser_feed(
+                &parser, &frame[offset], length < chunk ? length : chunk,
+                &consumed);
+        }
+        CHECK_EQUAL(NO_ERROR, ret);
+        /* the trailing start byte is left for the next frame */
+        CHECK_EQUAL(sizeof(frame) - 1, offset);
+        CHECK_EQUAL(0x03, parser.header.cmd);
+        CHECK_EQUAL(sizeof(expected), parser.header.data_len);
+        MEMCMP_EQUAL(expected, data, sizeof(expected));
+    }
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Rx_Parser_Errors) {
+    const uint8_t bad_crc[] = {0x7E, 0x00, 0x03, 0x00, 0x00, 0xFB, 0x7E};
+    const uint8_t too_long[] = {0x7E, 0x00, 0x03, 0x00, 0x04};
+    const uint8_t truncated[] = {0x7E, 0x00, 0x03, 0x7E};
+    struct sensirion_shdlc_rx_parser parser;
+    uint8_t data[3];
+    sensirion_shdlc_rx_parser_init(&parser, sizeof(data), data);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_CRC_MISMATCH,
+                sensirion_shdlc_rx_parser_feed(&parser, bad_crc,
+                                               sizeof(bad_crc), NULL));
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_FRAME_TOO_LONG,
+                sensirion_shdlc_rx_parser_feed(&parser, too_long,
+                                               sizeof(too_long), NULL));
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_ENCODING_ERROR,
+                sensirion_shdlc_rx_parser_feed(&parser, truncated,
+                                               sizeof(truncated), NULL));
+    /* the parser starts over with the next frame */
+    CHECK_EQUAL(SENSIRION_SHDLC_RX_STATE_HEADER, parser.state);
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Command_Timing) {
+    uint32_t latency_us;
+    uint32_t timeout_us;
+    uint16_t i;
+    sensirion_shdlc_get_command_timing(0x00, 0xD3, &latency_us, &timeout_us);
+    CHECK_EQUAL(SENSIRION_SHDLC_DEFAULT_LATENCY_US, latency_us);
+    CHECK_EQUAL(SENSIRION_SHDLC_DEFAULT_TIMEOUT_US, timeout_us);
+
+    CHECK_EQUAL(NO_ERROR,
+                sensirion_shdlc_set_command_timing(0x00, 0x03, 1000, 5000));
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_set_command_timing(0x00, 0xD3,
+                                                             100000, 500000));
+    sensirion_shdlc_get_command_timing(0x00, 0x03, &latency_us, &timeout_us);
+    CHECK_EQUAL(1000, latency_us);
+    CHECK_EQUAL(5000, timeout_us);
+    sensirion_shdlc_get_command_timing(0x00, 0xD3, &latency_us, &timeout_us);
+    CHECK_EQUAL(100000, latency_us);
+    CHECK_EQUAL(500000, timeout_us);
+
+    for (i = 0; i < SENSIRION_SHDLC_MAX_COMMAND_TIMINGS - 2; ++i) {
+        CHECK_EQUAL(NO_ERROR,
+                    sensirion_shdlc_set_command_timing(0x01, (uint8_t)i, 0, 0));
+    }
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_TIMING_TABLE_FULL,
+                sensirion_shdlc_set_command_timing(0x02, 0x00, 0, 0));
+    /* known commands can still be updated */
+    CHECK_EQUAL(NO_ERROR,
+                sensirion_shdlc_set_command_timing(0x00, 0x03, 2000, 5000));
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Command_Timing_Per_Port) {
+    struct sensirion_shdlc_port port;
+    uint32_t latency_us;
+    uint32_t timeout_us;
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_init(&port, "port"));
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_set_command_timing(
+                              &port, 0x00, 0x80, 3000, 9000));
+
+    sensirion_shdlc_port_get_command_timing(&port, 0x00, 0x80, &latency_us,
+                                            &timeout_us);
+    CHECK_EQUAL(3000, latency_us);
+    CHECK_EQUAL(9000, timeout_us);
+    /* the same address on the default port keeps the default timing */
+    sensirion_shdlc_get_command_timing(0x00, 0x80, &latency_us, &timeout_us);
+    CHECK_EQUAL(SENSIRION_SHDLC_DEFAULT_LATENCY_US, latency_us);
+    CHECK_EQUAL(SENSIRION_SHDLC_DEFAULT_TIMEOUT_US, timeout_us);
+    sensirion_shdlc_port_free(&port);
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Add_Bytes_Matches_Bytewise) {
+    uint8_t data[259];
+    uint8_t bulk_buf[2 * sizeof(data)];
+    uint8_t bytewise_buf[2 * sizeof(data)];
+    struct sensirion_shdlc_buffer bulk;
+    struct sensirion_shdlc_buffer bytewise;
+    uint16_t length;
+    uint16_t i;
+    for (i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t)(i * 7 + 0x11);
+    }
+    /* short lengths with the bytes to stuff at every position in a word */
+    for (length = 0; length < 40; ++length) {
+        bulk.data = bulk_buf;
+        bulk.offset = 0;
+        bulk.checksum = 0;
+        bytewise.data = bytewise_buf;
+        bytewise.offset = 0;
+        bytewise.checksum = 0;
+        sensirion_shdlc_add_bytes_to_frame(&bulk, data + 1, length);
+        for (i = 0; i < length; ++i) {
+            sensirion_shdlc_add_uint8_t_to_frame(&bytewise, data[1 + i]);
+        }
+        CHECK_EQUAL(bytewise.offset, bulk.offset);
+        CHECK_EQUAL(bytewise.checksum, bulk.checksum);
+        MEMCMP_EQUAL(bytewise_buf, bulk_buf, bytewise.offset);
+    }
+    /* every byte value */
+    bulk.offset = 0;
+    bulk.checksum = 0;
+    bytewise.offset = 0;
+    bytewise.checksum = 0;
+    for (i = 0; i < 256; ++i) {
+        data[i] = (uint8_t)i;
+        sensirion_shdlc_add_uint8_t_to_frame(&bytewise, data[i]);
+    }
+    sensirion_shdlc_add_bytes_to_frame(&bulk, data, 256);
+    CHECK_EQUAL(256 + 4, bulk.offset);
+    CHECK_EQUAL(bytewise.offset, bulk.offset);
+    CHECK_EQUAL(bytewise.checksum, bulk.checksum);
+    MEMCMP_EQUAL(bytewise_buf, bulk_buf, bytewise.offset);
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Tx_Vec_Matches_Buffered) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    uint8_t data[255];
+    uint8_t buffered[SENSIRION_TEST_UART_HAL_BUFFER_SIZE];
+    uint16_t buffered_length;
+    uint16_t length;
+    uint16_t pattern;
+    uint16_t i;
+
+    for (pattern = 0; pattern < 3; ++pattern) {
+        for (length = 0; length <= 255; length += 17) {
+            for (i = 0; i < length; ++i) {
+                if (pattern == 0) /* some bytes to stuff */
+                    data[i] = (uint8_t)(i * 37 + length);
+                else if (pattern == 1) /* only bytes to stuff */
+                    data[i] = 0x7E;
+                else /* every other byte to stuff */
+                    data[i] = (uint8_t)(i % 2 ? 0x11 : 0x42);
+            }
+
+            hal->tx_length = 0;
+            hal->has_tx_vec = false;
+            CHECK_EQUAL_ZERO(sensirion_shdlc_tx(0x00, 0x7D, (uint8_t)length,
+                                                data));
+            buffered_length = hal->tx_length;
+            memcpy(buffered, hal->tx_data, buffered_length);
+
+            hal->tx_length = 0;
+            hal->num_tx = 0;
+            hal->num_tx_vec = 0;
+            hal->has_tx_vec = true;
+            CHECK_EQUAL_ZERO(sensirion_shdlc_tx(0x00, 0x7D, (uint8_t)length,
+                                                data));
+            CHECK_EQUAL(buffered_length, hal->tx_length);
+            MEMCMP_EQUAL(buffered, hal->tx_data, buffered_length);
+            /* never falls back to the buffered frame */
+            CHECK_EQUAL_ZERO(hal->num_tx);
+            CHECK(hal->num_tx_vec >= 1);
+        }
+    }
+    /* 255 bytes to stuff need several calls */
+    CHECK(hal->num_tx_vec > 1);
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Rx_Parser_Long_Data) {
+    uint8_t payload[200];
+    uint8_t frame_buf[2 * (sizeof(payload) + 6)];
+    uint8_t data[sizeof(payload)];
+    struct sensirion_shdlc_buffer frame;
+    struct sensirion_shdlc_rx_parser parser;
+    uint16_t chunk;
+    uint16_t offset;
+    uint16_t consumed;
+    uint16_t i;
+    int16_t ret;
+    for (i = 0; i < sizeof(payload); ++i) {
+        payload[i] = (uint8_t)(i + 0x20);
+    }
+    /* one run without stuffed bytes, then a stuffed byte at an odd offset */
+    payload[151] = 0x7E;
+
+    frame.data = frame_buf;
+    frame.offset = 0;
+    frame.checksum = 0;
+    frame_buf[frame.offset++] = 0x7E;
+    sensirion_shdlc_add_uint8_t_to_frame(&frame, 0x00);
+    sensirion_shdlc_add_uint8_t_to_frame(&frame, 0x03);
+    sensirion_shdlc_add_uint8_t_to_frame(&frame, 0x00);
+    sensirion_shdlc_add_uint8_t_to_frame(&frame, sizeof(payload));
+    sensirion_shdlc_add_bytes_to_frame(&frame, payload, sizeof(payload));
+    sensirion_shdlc_finish_frame(&frame);
+
+    for (chunk = 1; chunk <= frame.offset; ++chunk) {
+        memset(data, 0, sizeof(data));
+        sensirion_shdlc_rx_parser_init(&parser, sizeof(data), data);
+        ret = SENSIRION_SHDLC_RX_INCOMPLETE;
+        for (offset = 0; ret == SENSIRION_SHDLC_RX_INCOMPLETE;
+             offset += consumed) {
+            ret = sensirion_shdlc_rx_parser_feed(
+                &parser, frame_buf + offset,
+                chunk < frame.offset - offset ? chunk : frame.offset - offset,
+                &consumed);
+        }
+        CHECK_EQUAL(NO_ERROR, ret);
+        CHECK_EQUAL(frame.offset, offset);
+        MEMCMP_EQUAL(payload, data, sizeof(payload));
+    }
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Rx_Keeps_Next_Frame) {
+    /* two responses delivered by a single read */
+    const uint8_t frames[] = {0x7E, 0x00, 0x03, 0x00, 0x03, 0x01, 0x7D,
+                              0x5E, 0x7D, 0x31, 0x69, 0x7E, 0x7E, 0x00,
+                              0x04, 0x00, 0x00, 0xFB, 0x7E};
+    const uint8_t expected[] = {0x01, 0x7E, 0x11};
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    struct sensirion_shdlc_port port;
+    struct sensirion_shdlc_rx_header header;
+    uint8_t data[3];
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_init(&port, "test"));
+    sensirion_test_uart_hal_respond(frames, sizeof(frames));
+
+    CHECK_EQUAL(NO_ERROR,
+                sensirion_shdlc_port_rx(&port, sizeof(data), &header, data));
+    CHECK_EQUAL(0x03, header.cmd);
+    MEMCMP_EQUAL(expected, data, sizeof(expected));
+    CHECK_EQUAL(1, hal->num_rx);
+    CHECK_EQUAL(7, port.rx_buffer.count);
+
+    /* the second response is taken from the buffer without reading */
+    CHECK_EQUAL(NO_ERROR,
+                sensirion_shdlc_port_rx(&port, sizeof(data), &header, data));
+    CHECK_EQUAL(0x04, header.cmd);
+    CHECK_EQUAL(0, header.data_len);
+    CHECK_EQUAL(1, hal->num_rx);
+    CHECK_EQUAL(0, port.rx_buffer.count);
+    sensirion_shdlc_port_free(&port);
+}
+
+/* MISO frame of a response with state 0 */
+static uint16_t build_response(uint8_t* buf, uint8_t cmd, uint8_t data_len,
+                               const uint8_t* data) {
+    struct sensirion_shdlc_buffer frame;
+    frame.data = buf;
+    frame.offset = 0;
+    frame.checksum = 0;
+    buf[frame.offset++] = 0x7E;
+    sensirion_shdlc_add_uint8_t_to_frame(&frame, 0x00);
+    sensirion_shdlc_add_uint8_t_to_frame(&frame, cmd);
+    sensirion_shdlc_add_uint8_t_to_frame(&frame, 0x00);
+    sensirion_shdlc_add_uint8_t_to_frame(&frame, data_len);
+    sensirion_shdlc_add_bytes_to_frame(&frame, data, data_len);
+    sensirion_shdlc_finish_frame(&frame);
+    return frame.offset;
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Rx_Refills_Buffer) {
+    /* reads of any size, a frame longer than the receive buffer and the start
+     * of the next frame read together with the end of the first */
+    const uint16_t chunks[] = {0, 1, 7, SENSIRION_SHDLC_RX_BUFFER_SIZE - 1};
+    const uint8_t next_payload[] = {0x7D, 0x11};
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    struct sensirion_shdlc_port port;
+    struct sensirion_shdlc_rx_header header;
+    uint8_t payload[200];
+    uint8_t frames[2 * (sizeof(payload) + 6) + 2 * (sizeof(next_payload) + 6)];
+    uint8_t data[sizeof(payload)];
+    uint16_t length;
+    uint16_t i;
+    for (i = 0; i < sizeof(payload); ++i) {
+        payload[i] = (uint8_t)(i * 3 + 0x70);
+    }
+    length = build_response(frames, 0x03, sizeof(payload), payload);
+    length += build_response(frames + length, 0x04, sizeof(next_payload),
+                             next_payload);
+    CHECK(length > 3 * SENSIRION_SHDLC_RX_BUFFER_SIZE);
+
+    for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); ++i) {
+        sensirion_test_uart_hal_reset();
+        hal->rx_chunk = chunks[i];
+        CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_init(&port, "test"));
+        sensirion_test_uart_hal_respond(frames, length);
+
+        memset(data, 0, sizeof(data));
+        CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_rx(&port, sizeof(data),
+                                                      &header, data));
+        CHECK_EQUAL(0x03, header.cmd);
+        CHECK_EQUAL(sizeof(payload), header.data_len);
+        MEMCMP_EQUAL(payload, data, sizeof(payload));
+
+        CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_rx(&port, sizeof(data),
+                                                      &header, data));
+        CHECK_EQUAL(0x04, header.cmd);
+        CHECK_EQUAL(sizeof(next_payload), header.data_len);
+        MEMCMP_EQUAL(next_payload, data, sizeof(next_payload));
+        CHECK_EQUAL(0, port.rx_buffer.count);
+        CHECK_EQUAL(length, hal->rx_position);
+        sensirion_shdlc_port_free(&port);
+    }
+}
+
+/* queue a response to command 0x03 with the data 0x01 0x7E 0x11 */
+static void respond_to_xcv(void) {
+    const uint8_t payload[] = {0x01, 0x7E, 0x11};
+    uint8_t frame[2 * (sizeof(payload) + 6)];
+    sensirion_test_uart_hal_respond(
+        frame, build_response(frame, 0x03, sizeof(payload), payload));
+}
+
+/* transceive command 0x03 and check the response of respond_to_xcv() */
+static void check_xcv(struct sensirion_shdlc_port* port, uint32_t timeout_us,
+                      int16_t expected_ret) {
+    const uint8_t expected[] = {0x01, 0x7E, 0x11};
+    struct sensirion_shdlc_rx_header header;
+    uint8_t data[sizeof(expected)];
+    CHECK_EQUAL(expected_ret, sensirion_shdlc_port_xcv_timeout(
+                                  port, 0x00, 0x03, 0, NULL, sizeof(data),
+                                  &header, data, timeout_us));
+    if (expected_ret == NO_ERROR) {
+        CHECK_EQUAL(0x03, header.cmd);
+        CHECK_EQUAL(sizeof(expected), header.data_len);
+        MEMCMP_EQUAL(expected, data, sizeof(expected));
+    }
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Xcv_Waits_For_Response) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    struct sensirion_shdlc_port port;
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_init(&port, "test"));
+    hal->has_wait_rx = true;
+    hal->latency_usec = 1500;
+    hal->rx_chunk = 4;
+    respond_to_xcv();
+
+    check_xcv(&port, 100000, NO_ERROR);
+    /* done when the response arrives instead of after a fixed delay */
+    CHECK_EQUAL(1500, hal->time_usec);
+    CHECK_EQUAL_ZERO(hal->slept_usec);
+    CHECK(hal->num_wait_rx >= 1);
+    sensirion_shdlc_port_free(&port);
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Xcv_Timeout) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    struct sensirion_shdlc_port port;
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_init(&port, "test"));
+    hal->has_wait_rx = true;
+
+    /* no response at all */
+    check_xcv(&port, 10000, SENSIRION_SHDLC_ERR_TIMEOUT);
+    CHECK_EQUAL(10000, hal->time_usec);
+
+    /* response later than the timeout */
+    hal->time_usec = 0;
+    hal->latency_usec = 50000;
+    respond_to_xcv();
+    check_xcv(&port, 10000, SENSIRION_SHDLC_ERR_TIMEOUT);
+    CHECK_EQUAL(10000, hal->time_usec);
+    CHECK_EQUAL_ZERO(hal->num_rx);
+    sensirion_shdlc_port_free(&port);
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Xcv_Sleeps_Without_Wait_Rx) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    struct sensirion_shdlc_port port;
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_init(&port, "test"));
+    hal->latency_usec = 1500;
+    respond_to_xcv();
+
+    /* sensirion_uart_hal_port_wait_rx() is not implemented */
+    check_xcv(&port, 100000, NO_ERROR);
+    CHECK_EQUAL(SENSIRION_SHDLC_DEFAULT_LATENCY_US, hal->slept_usec);
+    CHECK_EQUAL_ZERO(hal->num_wait_rx);
+    sensirion_shdlc_port_free(&port);
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Xcv_Sleeps_Most_Of_Known_Latency) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    struct sensirion_shdlc_port port;
+    struct sensirion_shdlc_rx_header header;
+    uint8_t data[3];
+    uint32_t latency_us;
+    uint32_t timeout_us;
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_init(&port, "test"));
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_set_command_timing(
+                              &port, 0x00, 0x03, 8000, 100000));
+    hal->has_wait_rx = true;
+    hal->has_time = true;
+    hal->latency_usec = 10000;
+    respond_to_xcv();
+
+    check_xcv(&port, 100000, NO_ERROR);
+    /* three quarters of the expected latency, then wait for the rest */
+    CHECK_EQUAL(6000, hal->slept_usec);
+    CHECK_EQUAL(10000, hal->time_usec);
+    /* moving average with weight 1/8: 8000 - 8000 / 8 + 10000 / 8 */
+    sensirion_shdlc_port_get_command_timing(&port, 0x00, 0x03, &latency_us,
+                                            &timeout_us);
+    CHECK_EQUAL(8250, latency_us);
+    CHECK_EQUAL(100000, timeout_us);
+
+    /* the timeout of the command limits the wait */
+    hal->time_usec = 0;
+    hal->slept_usec = 0;
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_set_command_timing(
+                              &port, 0x00, 0x03, 8000, 9000));
+    respond_to_xcv();
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_TIMEOUT,
+                sensirion_shdlc_port_xcv(&port, 0x00, 0x03, 0, NULL,
+                                         sizeof(data), &header, data));
+    CHECK_EQUAL(6000, hal->slept_usec);
+    CHECK_EQUAL(9000, hal->time_usec);
+    sensirion_shdlc_port_free(&port);
+}
+
+TEST (EmbeddedCommon_SHDLC_Tests, Xcv_Learns_Latency) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    struct sensirion_shdlc_port port;
+    uint32_t latency_us;
+    uint32_t timeout_us;
+    CHECK_EQUAL(NO_ERROR, sensirion_shdlc_port_init(&port, "test"));
+    hal->has_wait_rx = true;
+    hal->latency_usec = 3000;
+
+    /* nothing is learned without a time source */
+    respond_to_xcv();
+    check_xcv(&port, 100000, NO_ERROR);
+    sensirion_shdlc_port_get_command_timing(&port, 0x00, 0x03, &latency_us,
+                                            &timeout_us);
+    CHECK_EQUAL(SENSIRION_SHDLC_DEFAULT_LATENCY_US, latency_us);
+
+    /* the measured latency of an unknown command is added to the table */
+    hal->has_time = true;
+    respond_to_xcv();
+    check_xcv(&port, 100000, NO_ERROR);
+    sensirion_shdlc_port_get_command_timing(&port, 0x00, 0x03, &latency_us,
+                                            &timeout_us);
+    CHECK_EQUAL(3000, latency_us);
+    CHECK_EQUAL(SENSIRION_SHDLC_DEFAULT_TIMEOUT_US, timeout_us);
+    CHECK_EQUAL_ZERO(hal->slept_usec);
+
+    /* and used for the next transceive */
+    respond_to_xcv();
+    check_xcv(&port, 100000, NO_ERROR);
+    CHECK_EQUAL(2250, hal->slept_usec);
+    sensirion_shdlc_port_get_command_timing(&port, 0x00, 0x03, &latency_us,
+                                            &timeout_us);
+    CHECK_EQUAL(3000, latency_us);
+    sensirion_shdlc_port_free(&port);
+}
+
+TEST (EmbeddedCommon_Common_Tests, Reader_Typed_Values) {
+    const uint8_t data[] = {0x12, 0xFF, 0xFE, 0x3F, 0xC0, 0x00, 0x00,
+                            0xFF, 0xFF, 0xFF, 0xFD, 0x00, 0x2A};
+    struct sensirion_common_reader reader;
+    sensirion_common_reader_init(&reader, data, sizeof(data));
+    CHECK_EQUAL(0x12, sensirion_common_reader_get_uint8_t(&reader));
+    CHECK_EQUAL(-2, sensirion_common_reader_get_int16_t(&reader));
+    DOUBLES_EQUAL(1.5, sensirion_common_reader_get_float(&reader), 0.0);
+    CHECK_EQUAL(-3, sensirion_common_reader_get_int32_t(&reader));
+    CHECK_EQUAL(42, sensirion_common_reader_get_uint16_t(&reader));
+    CHECK_FALSE(reader.error);
+
+    /* reading past the end fails and the error sticks */
+    CHECK_EQUAL(0, sensirion_common_reader_get_uint8_t(&reader));
+    CHECK_TRUE(reader.error);
+    sensirion_common_reader_init(&reader, data, 3);
+    CHECK_EQUAL(0, sensirion_common_reader_get_uint32_t(&reader));
+    CHECK_EQUAL(0, sensirion_common_reader_get_uint8_t(&reader));
+    CHECK_TRUE(reader.error);
+}
+
+TEST (EmbeddedCommon_Common_Tests, Reader_Arrays) {
+    uint8_t data[10 * 4];
+    float values[10];
+    uint16_t words[3];
+    struct sensirion_common_reader reader;
+    uint16_t i;
+    for (i = 0; i < 10; ++i) {
+        sensirion_common_float_to_bytes((float)i * 0.25f - 1.0f, &data[i * 4]);
+    }
+    sensirion_common_reader_init(&reader, data, sizeof(data));
+    sensirion_common_reader_get_float_array(&reader, values, 10);
+    CHECK_FALSE(reader.error);
+    for (i = 0; i < 10; ++i) {
+        DOUBLES_EQUAL((float)i * 0.25f - 1.0f, values[i], 0.0);
+    }
+
+    sensirion_common_reader_init(&reader, data, 6);
+    sensirion_common_reader_get_uint16_t_array(&reader, words, 3);
+    CHECK_FALSE(reader.error);
+    CHECK_EQUAL(sensirion_common_bytes_to_uint16_t(&data[4]), words[2]);
+    sensirion_common_reader_init(&reader, data, 6);
+    sensirion_common_reader_get_float_array(&reader, values, 2);
+    CHECK_TRUE(reader.error);
+    DOUBLES_EQUAL(0.0, values[1], 0.0);
+    CHECK_EQUAL(0, reader.offset);
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2026, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sensirion_test_i2c_hal.h"
+#include "sensirion_common.h"
+#include "sensirion_config.h"
+#include "sensirion_i2c.h"
+#include "sensirion_i2c_hal.h"
+
+#include <string.h>
+
+struct sensirion_test_i2c_hal sensirion_test_i2c_hal;
+
+void sensirion_test_i2c_hal_reset(void) {
+    memset(&sensirion_test_i2c_hal, 0, sizeof(sensirion_test_i2c_hal));
+    sensirion_test_i2c_hal.tick_usec = 1;
+}
+
+static int8_t sensirion_test_i2c_op(uint8_t address, uint8_t tx_count,
+                                    uint8_t* rx_data, uint8_t rx_count) {
+    struct sensirion_test_i2c_hal* hal = &sensirion_test_i2c_hal;
+    struct sensirion_test_i2c_op* op;
+    uint8_t i;
+
+    if (hal->num_ops < SENSIRION_TEST_I2C_HAL_MAX_OPS) {
+        op = &hal->ops[hal->num_ops++];
+        op->address = address;
+        op->tx_count = tx_count;
+        op->rx_count = rx_count;
+        op->time_usec = hal->time_usec;
+    }
+    hal->time_usec += hal->op_usec;
+
+    if (hal->error)
+        return hal->error;
+    if (address == hal->fail_address)
+        return I2C_BUS_ERROR;
+
+    for (i = 0; i + SENSIRION_WORD_SIZE + CRC8_LEN <= rx_count;
+         i += SENSIRION_WORD_SIZE + CRC8_LEN) {
+        rx_data[i] = address;
+        rx_data[i + 1] = (uint8_t)(i / (SENSIRION_WORD_SIZE + CRC8_LEN));
+        rx_data[i + 2] =
+            sensirion_i2c_generate_crc(&rx_data[i], SENSIRION_WORD_SIZE);
+        if (address == hal->crc_error_address)
+            rx_data[i + 2] ^= 0xFF;
+    }
+    return NO_ERROR;
+}
+
+int16_t sensirion_i2c_hal_select_bus(uint8_t bus_idx) {
+    return NO_ERROR;
+}
+
+void sensirion_i2c_hal_init(void) {
+}
+
+void sensirion_i2c_hal_free(void) {
+}
+
+int8_t sensirion_i2c_hal_read(uint8_t address, uint8_t* data, uint8_t count) {
+    return sensirion_test_i2c_op(address, 0, data, count);
+}
+
+int8_t sensirion_i2c_hal_write(uint8_t address, const uint8_t* data,
+                               uint8_t count) {
+    return sensirion_test_i2c_op(address, count, NULL, 0);
+}
+
+int8_t sensirion_i2c_hal_write_read(uint8_t address, const uint8_t* tx_data,
+                                    uint8_t tx_count, uint8_t* rx_data,
+                                    uint8_t rx_count) {
+    if (!sensirion_test_i2c_hal.has_write_read)
+        return NOT_IMPLEMENTED_ERROR;
+    return sensirion_test_i2c_op(address, tx_count, rx_data, rx_count);
+}
+
+int8_t sensirion_i2c_hal_transfer(struct sensirion_i2c_hal_transfer* transfers,
+                                  uint16_t count) {
+    int8_t ret = NO_ERROR;
+    uint16_t i;
+
+    ++sensirion_test_i2c_hal.num_transfer_calls;
+    if (!sensirion_test_i2c_hal.has_transfer)
+        return NOT_IMPLEMENTED_ERROR;
+
+    for (i = 0; i < count; ++i) {
+        transfers[i].error = sensirion_test_i2c_op(
+            transfers[i].address, transfers[i].tx_count, transfers[i].rx_data,
+            transfers[i].rx_count);
+        if (transfers[i].error)
+            ret = transfers[i].error;
+    }
+    return ret;
+}
+
+int16_t sensirion_i2c_hal_bus_init(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t bus_idx) {
+    bus->bus_idx = bus_idx;
+    bus->handle = 0;
+    bus->address = 0;
+    return NO_ERROR;
+}
+
+void sensirion_i2c_hal_bus_free(struct sensirion_i2c_hal_bus* bus) {
+}
+
+int8_t sensirion_i2c_hal_bus_read(struct sensirion_i2c_hal_bus* bus,
+                                  uint8_t address, uint8_t* data,
+                                  uint8_t count) {
+    return sensirion_i2c_hal_read(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_bus_write(struct sensirion_i2c_hal_bus* bus,
+                                   uint8_t address, const uint8_t* data,
+                                   uint8_t count) {
+    return sensirion_i2c_hal_write(address, data, count);
+}
+
+int8_t sensirion_i2c_hal_bus_write_read(struct sensirion_i2c_hal_bus* bus,
+                                        uint8_t address, const uint8_t* tx_data,
+                                        uint8_t tx_count, uint8_t* rx_data,
+                                        uint8_t rx_count) {
+    return sensirion_i2c_hal_write_read(address, tx_data, tx_count, rx_data,
+                                        rx_count);
+}
+
+int8_t
+sensirion_i2c_hal_bus_transfer(struct sensirion_i2c_hal_bus* bus,
+                               struct sensirion_i2c_hal_transfer* transfers,
+                               uint16_t count) {
+    return sensirion_i2c_hal_transfer(transfers, count);
+}
+
+uint32_t sensirion_i2c_hal_get_time_usec(void) {
+    uint32_t now = sensirion_test_i2c_hal.time_usec;
+
+    return now - now % sensirion_test_i2c_hal.tick_usec;
+}
+
+void sensirion_i2c_hal_sleep_usec(uint32_t useconds) {
+    sensirion_test_i2c_hal.time_usec += useconds;
+    sensirion_test_i2c_hal.slept_usec += useconds;
+}
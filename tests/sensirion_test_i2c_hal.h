@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2026, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SENSIRION_TEST_I2C_HAL_H
+#define SENSIRION_TEST_I2C_HAL_H
+
+#include "sensirion_config.h"
+#include "sensirion_i2c_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SENSIRION_TEST_I2C_HAL_MAX_OPS 256
+
+/**
+ * One bus operation recorded by the stub I2C HAL of the tests. A combined
+ * write and read has both counts set.
+ */
+struct sensirion_test_i2c_op {
+    uint8_t address;
+    uint8_t tx_count;
+    uint8_t rx_count;
+    uint32_t time_usec; /* true time at the start of the operation */
+};
+
+/**
+ * State of the stub I2C HAL which replaces the HAL template in the tests.
+ * Reads return the words (address << 8) | word_index with valid CRCs.
+ */
+struct sensirion_test_i2c_hal {
+    /* configuration */
+    uint32_t time_usec; /* true time, advanced by operations and sleeps */
+    uint32_t tick_usec; /* resolution of sensirion_i2c_hal_get_time_usec() */
+    uint32_t op_usec;   /* duration of every bus operation */
+    int8_t error;       /* returned by every operation if not 0 */
+    uint8_t fail_address;      /* operations on this address fail, 0: none */
+    uint8_t crc_error_address; /* reads from it have bad CRCs, 0: none */
+    bool has_write_read;       /* implement sensirion_i2c_hal_write_read() */
+    bool has_transfer;         /* implement sensirion_i2c_hal_transfer() */
+
+    /* recorded */
+    struct sensirion_test_i2c_op ops[SENSIRION_TEST_I2C_HAL_MAX_OPS];
+    uint16_t num_ops;
+    uint16_t num_transfer_calls;
+    uint32_t slept_usec;
+};
+
+extern struct sensirion_test_i2c_hal sensirion_test_i2c_hal;
+
+/**
+ * Reset the stub I2C HAL: time 0 with microsecond resolution, operations
+ * take no time and succeed, no optional functions, nothing recorded.
+ */
+void sensirion_test_i2c_hal_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSIRION_TEST_I2C_HAL_H */
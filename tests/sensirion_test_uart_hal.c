@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2026, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sensirion_test_uart_hal.h"
+#include "sensirion_common.h"
+#include "sensirion_config.h"
+#include "sensirion_uart_hal.h"
+
+#include <string.h>
+
+struct sensirion_test_uart_hal sensirion_test_uart_hal;
+
+void sensirion_test_uart_hal_reset(void) {
+    memset(&sensirion_test_uart_hal, 0, sizeof(sensirion_test_uart_hal));
+}
+
+void sensirion_test_uart_hal_respond(const uint8_t* data, uint16_t length) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+
+    memcpy(hal->rx_data + hal->rx_length, data, length);
+    hal->rx_length += length;
+}
+
+static void sensirion_test_uart_transmit(const uint8_t* data,
+                                         uint16_t length) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+
+    memcpy(hal->tx_data + hal->tx_length, data, length);
+    hal->tx_length += length;
+    hal->rx_ready_usec = hal->time_usec + hal->latency_usec;
+}
+
+int16_t sensirion_uart_hal_init() {
+    return NO_ERROR;
+}
+
+int16_t sensirion_uart_hal_free() {
+    return NO_ERROR;
+}
+
+int16_t sensirion_uart_hal_tx(uint16_t data_len, const uint8_t* data) {
+    return sensirion_uart_hal_port_tx(NULL, data_len, data);
+}
+
+int16_t sensirion_uart_hal_rx(uint16_t max_data_len, uint8_t* data) {
+    return sensirion_uart_hal_port_rx(NULL, max_data_len, data);
+}
+
+int16_t sensirion_uart_hal_port_init(struct sensirion_uart_hal_port* port,
+                                     const char* device) {
+    port->device = device;
+    port->handle = 0;
+    return NO_ERROR;
+}
+
+int16_t sensirion_uart_hal_port_free(struct sensirion_uart_hal_port* port) {
+    return NO_ERROR;
+}
+
+int16_t sensirion_uart_hal_port_set_baudrate(
+    struct sensirion_uart_hal_port* port, uint32_t baudrate) {
+    return NOT_IMPLEMENTED_ERROR;
+}
+
+int16_t sensirion_uart_hal_port_tx(struct sensirion_uart_hal_port* port,
+                                   uint16_t data_len, const uint8_t* data) {
+    ++sensirion_test_uart_hal.num_tx;
+    sensirion_test_uart_transmit(data, data_len);
+    return (int16_t)data_len;
+}
+
+int16_t sensirion_uart_hal_port_rx(struct sensirion_uart_hal_port* port,
+                                   uint16_t max_data_len, uint8_t* data) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    uint16_t length = (uint16_t)(hal->rx_length - hal->rx_position);
+
+    ++hal->num_rx;
+    if (!length)
+        return 0; /* the read timed out */
+
+    /* block until the response arrives */
+    if ((int32_t)(hal->rx_ready_usec - hal->time_usec) > 0)
+        hal->time_usec = hal->rx_ready_usec;
+
+    if (length > max_data_len)
+        length = max_data_len;
+    if (hal->rx_chunk && length > hal->rx_chunk)
+        length = hal->rx_chunk;
+    memcpy(data, hal->rx_data + hal->rx_position, length);
+    hal->rx_position += length;
+    return (int16_t)length;
+}
+
+int16_t sensirion_uart_hal_port_tx_vec(
+    struct sensirion_uart_hal_port* port,
+    const struct sensirion_uart_hal_segment* segments, uint16_t num_segments) {
+    uint16_t i;
+
+    if (!sensirion_test_uart_hal.has_tx_vec)
+        return NOT_IMPLEMENTED_ERROR;
+    if (num_segments > SENSIRION_UART_HAL_MAX_SEGMENTS)
+        return -1;
+
+    ++sensirion_test_uart_hal.num_tx_vec;
+    for (i = 0; i < num_segments; ++i)
+        sensirion_test_uart_transmit(segments[i].data, segments[i].length);
+    return NO_ERROR;
+}
+
+int16_t sensirion_uart_hal_port_wait_rx(struct sensirion_uart_hal_port* port,
+                                        uint32_t timeout_us) {
+    struct sensirion_test_uart_hal* hal = &sensirion_test_uart_hal;
+    int32_t remaining = (int32_t)(hal->rx_ready_usec - hal->time_usec);
+
+    if (!hal->has_wait_rx)
+        return NOT_IMPLEMENTED_ERROR;
+
+    ++hal->num_wait_rx;
+    if (hal->rx_position < hal->rx_length &&
+        (remaining <= 0 || (uint32_t)remaining <= timeout_us)) {
+        if (remaining > 0)
+            hal->time_usec += (uint32_t)remaining;
+        return 1;
+    }
+    hal->time_usec += timeout_us;
+    return 0;
+}
+
+uint32_t sensirion_uart_hal_get_time_usec(void) {
+    return sensirion_test_uart_hal.has_time ? sensirion_test_uart_hal.time_usec
+                                            : 0;
+}
+
+void sensirion_uart_hal_sleep_usec(uint32_t useconds) {
+    sensirion_test_uart_hal.time_usec += useconds;
+    sensirion_test_uart_hal.slept_usec += useconds;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SENSIRION_TEST_UART_HAL_H
+#define SENSIRION_TEST_UART_HAL_H
+
+#include "sensirion_config.h"
+#include "sensirion_uart_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SENSIRION_TEST_UART_HAL_BUFFER_SIZE 1024
+
+/**
+ * State of the stub UART HAL which replaces the HAL template in the tests. The
+ * device answers every transmission after latency_usec with the bytes queued
+ * by sensirion_test_uart_hal_respond().
+ */
+struct sensirion_test_uart_hal {
+    /* configuration */
+    uint32_t time_usec;    /* true time, advanced by sleeps, waits and reads */
+    uint32_t latency_usec; /* time from a transmission to the response */
+    uint16_t rx_chunk;     /* max bytes returned by one read, 0: no limit */
+    bool has_time;         /* implement sensirion_uart_hal_get_time_usec() */
+    bool has_tx_vec;       /* implement sensirion_uart_hal_port_tx_vec() */
+    bool has_wait_rx;      /* implement sensirion_uart_hal_port_wait_rx() */
+
+    /* bytes sent by the device */
+    uint8_t rx_data[SENSIRION_TEST_UART_HAL_BUFFER_SIZE];
+    uint16_t rx_length;
+    uint16_t rx_position;
+    uint32_t rx_ready_usec; /* time at which the response starts */
+
+    /* recorded */
+    uint8_t tx_data[SENSIRION_TEST_UART_HAL_BUFFER_SIZE];
+    uint16_t tx_length;
+    uint16_t num_tx;     /* calls of sensirion_uart_hal_port_tx() */
+    uint16_t num_tx_vec; /* calls of sensirion_uart_hal_port_tx_vec() */
+    uint16_t num_rx;     /* calls of sensirion_uart_hal_port_rx() */
+    uint16_t num_wait_rx;
+    uint32_t slept_usec;
+};
+
+extern struct sensirion_test_uart_hal sensirion_test_uart_hal;
+
+/**
+ * Reset the stub UART HAL: time 0, no optional functions, no response, nothing
+ * recorded.
+ */
+void sensirion_test_uart_hal_reset(void);
+
+/**
+ * Queue bytes for the device to send after the next transmission.
+ */
+void sensirion_test_uart_hal_respond(const uint8_t* data, uint16_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSIRION_TEST_UART_HAL_H */